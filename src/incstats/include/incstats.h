@@ -6,9 +6,12 @@
 #define _USE_MATH_DEFINES
 #endif
 
+#include <float.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
 
 
 /**
@@ -83,6 +86,39 @@ inline uint64_t n_choose_k(uint64_t n, uint64_t k) {
 }
 
 
+/**
+ * @brief The highest order n for which the binomial coefficients are 
+ * tabulated in `incstats_binomials`.
+ */
+#define INCSTATS_BINOMIAL_MAX_ORDER 40
+
+/**
+ * @brief Binomial coefficients (n choose k) for 
+ * 0 <= k <= n <= INCSTATS_BINOMIAL_MAX_ORDER.
+ *
+ * The table is a constant initialized at compile time and holds the rows of
+ * Pascal's triangle one after another, i.e. (n choose k) is stored at index
+ * n * (n + 1) / 2 + k. All entries are exactly representable as doubles.
+ */
+extern const double incstats_binomials[];
+
+/**
+ * @brief Computes the binomial coefficient (n choose k) as a double.
+ *
+ * For n <= INCSTATS_BINOMIAL_MAX_ORDER the coefficient is looked up in 
+ * `incstats_binomials`, otherwise it is computed by n_choose_k.
+ * 
+ * @param n The total number of elements in the set.
+ * @param k The number of elements to choose from the set. Must not exceed n.
+ * @return The binomial coefficient (n choose k).
+ */
+inline double incstats_binomial(uint64_t n, uint64_t k) {
+    if(n <= INCSTATS_BINOMIAL_MAX_ORDER) {
+        return incstats_binomials[n * (n + 1) / 2 + k];
+    }
+    return (double)n_choose_k(n, k);
+}
+
 /**
  * @brief Updates the running mean of a dataset.
  *
@@ -291,17 +327,43 @@ inline void incstats_kurtosis_finalize(double *results, double *buffer) {
  */
 inline void incstats_central_moment(double x, double w, double *buffer, uint64_t p) {
     double new_sum_w = buffer[0] + w;
+    double delta_old = -w * (x - buffer[1]) / new_sum_w;
+    double delta_new = buffer[0] * (x - buffer[1]) / new_sum_w;
 
     for(uint64_t i = p; i > 1; i--) {
         double tmp = 0.0;
-        for(uint64_t k = i - 2; k > 0; k--) {
-           tmp += n_choose_k(i, k) * buffer[i - k] * 
-                  incstats_pow(-w * (x - buffer[1]) / new_sum_w, k);  
+        double power = 1.0;
+        if(i <= INCSTATS_BINOMIAL_MAX_ORDER) {
+            const double *row = &incstats_binomials[i * (i + 1) / 2];
+            for(uint64_t k = 1; k < i - 1; k++) {
+                power *= delta_old;
+                tmp += row[k] * buffer[i - k] * power;
+            }
         }
+        else {
+            // Beyond the table the coefficients are computed by the 
+            // recurrence C(i, k) = C(i, k - 1) (i - k + 1) / k along the 
+            // loop. It is exact in integers while the product fits into 64
+            // bits and rounded in double afterwards.
+            uint64_t exact = 1;
+            double binomial = 1.0;
+            for(uint64_t k = 1; k < i - 1; k++) {
+                if(exact != 0 && exact <= UINT64_MAX / (i - k + 1)) {
+                    exact = exact * (i - k + 1) / k;
+                    binomial = (double)exact;
+                }
+                else {
+                    exact = 0;
+                    binomial = binomial * (double)(i - k + 1) / (double)k;
+                }
+                power *= delta_old;
+                tmp += binomial * buffer[i - k] * power;
+            }
+        }
+        // power holds delta_old^(i - 2) at this point.
         buffer[i] = buffer[i] + tmp +
-                    buffer[0] * incstats_pow(-w * (x - buffer[1]) / 
-                    new_sum_w, i) + w * incstats_pow(buffer[0] * 
-                    (x - buffer[1]) / new_sum_w, i);
+                    buffer[0] * power * delta_old * delta_old + w * 
+                    incstats_pow(delta_new, i);
     }
     buffer[1] = buffer[1] + w / new_sum_w * (x - buffer[1]);
     buffer[0] = new_sum_w;
@@ -383,4 +445,3044 @@ inline void incstats_min(double x, double *min) {
     }
 }
 
+/**
+ * @brief Updates the running mean, variance, skewness, kurtosis, maximum and
+ * minimum of a dataset in a single pass.
+ *
+ * This function combines `incstats_kurtosis`, `incstats_max` and 
+ * `incstats_min` into one update so that all summary statistics share the 
+ * sum of weights and the mean instead of keeping separate copies.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param w The weight of the new value `x`.
+ * @param buffer A pointer to a double array of length 7:
+ *               - `buffer[0]` to `buffer[4]` hold the state of 
+ *                 `incstats_kurtosis`.
+ *               - `buffer[5]` holds the running maximum.
+ *               - `buffer[6]` holds the running minimum.
+ * 
+ * @note The results shall be finalized by incstats_summary_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use. The 
+ * maximum and minimum are seeded with the first value.
+ */
+inline void incstats_summary(double x, double w, double *buffer) {
+    if(buffer[0] == 0.0) {
+        buffer[5] = x;
+        buffer[6] = x;
+    }
+    incstats_kurtosis(x, w, buffer);
+    incstats_max(x, &buffer[5]);
+    incstats_min(x, &buffer[6]);
+}
+
+/**
+ * @brief Finalizes the computation of the running summary statistics.
+ *
+ * @param results A pointer to an array of length 6 where the final values 
+ * will be stored:
+ *                - `results[0]` will store the final mean value.
+ *                - `results[1]` will store the final variance value.
+ *                - `results[2]` will store the final skewness value.
+ *                - `results[3]` will store the final kurtosis value.
+ *                - `results[4]` will store the maximum value.
+ *                - `results[5]` will store the minimum value.
+ * @param buffer A pointer to a double array of length 7.
+ * 
+ * @note This function should be used to finalize the results obtained by 
+ * `incstats_summary`. This call is non-destructive, allowing multiple calls to
+ * the same buffer.
+ */
+inline void incstats_summary_finalize(double *results, double *buffer) {
+    incstats_kurtosis_finalize(results, buffer);
+    results[4] = buffer[5];
+    results[5] = buffer[6];
+}
+
+/**
+ * @brief The highest order of central moments that `incstats_moments` keeps
+ * in its inline storage. Higher orders are allocated on the heap.
+ */
+#define INCSTATS_MOMENTS_INLINE_ORDER 8
+
+/**
+ * @brief A user supplied allocator, e.g. to serve buffers from a pool.
+ *
+ * `allocate` shall return a pointer to at least `size` bytes suitably aligned
+ * for doubles or NULL on failure. `deallocate` releases memory obtained from
+ * `allocate`. `context` is passed through to both functions unchanged.
+ */
+typedef struct {
+    void *(*allocate)(size_t size, void *context);
+    void (*deallocate)(void *ptr, void *context);
+    void *context;
+} incstats_allocator;
+
+/**
+ * @brief Accumulator for central moments up to a runtime chosen order.
+ *
+ * Orders up to INCSTATS_MOMENTS_INLINE_ORDER are stored inside the struct, so
+ * no allocation happens for the common case. Higher orders spill to memory 
+ * obtained from the allocator given to incstats_moments_init.
+ * 
+ * @note The struct owns its heap memory. Use incstats_moments_move to 
+ * transfer it and incstats_moments_free to release it. Do not copy it 
+ * otherwise.
+ */
+typedef struct {
+    uint64_t p;
+    double *heap;
+    double storage[INCSTATS_MOMENTS_INLINE_ORDER + 1];
+    incstats_allocator allocator;
+} incstats_moments;
+
+/**
+ * @brief Initializes a central moment accumulator of order `p`.
+ *
+ * @param moments A pointer to the accumulator to initialize.
+ * @param p The order of the highest central moment to track.
+ * @param allocator A pointer to the allocator used if `p` exceeds 
+ * INCSTATS_MOMENTS_INLINE_ORDER or NULL to use malloc and free. The 
+ * allocator is copied into the accumulator.
+ * @return true on success, false if the allocation failed.
+ */
+inline bool incstats_moments_init(incstats_moments *moments, uint64_t p,
+const incstats_allocator *allocator) {
+    size_t length = p + 1 < 2 ? 2 : p + 1;
+
+    moments->p = p;
+    moments->heap = NULL;
+    memset(moments->storage, 0, sizeof(moments->storage));
+    if(allocator != NULL) {
+        moments->allocator = *allocator;
+    }
+    else {
+        moments->allocator.allocate = NULL;
+        moments->allocator.deallocate = NULL;
+        moments->allocator.context = NULL;
+    }
+    if(p > INCSTATS_MOMENTS_INLINE_ORDER) {
+        if(moments->allocator.allocate != NULL) {
+            moments->heap = (double *)moments->allocator.allocate(
+                            length * sizeof(double), 
+                            moments->allocator.context);
+        }
+        else {
+            moments->heap = (double *)malloc(length * sizeof(double));
+        }
+        if(moments->heap == NULL) {
+            return false;
+        }
+        memset(moments->heap, 0, length * sizeof(double));
+    }
+    return true;
+}
+
+/**
+ * @brief Returns the buffer of an `incstats_moments` accumulator.
+ *
+ * @param moments A pointer to an initialized accumulator.
+ * @return A pointer to the buffer of length max(2, p + 1) as used by 
+ * `incstats_central_moment`.
+ */
+inline double *incstats_moments_buffer(incstats_moments *moments) {
+    return moments->p > INCSTATS_MOMENTS_INLINE_ORDER ? moments->heap : 
+           moments->storage;
+}
+
+/**
+ * @brief Updates the running central moments held by `moments`.
+ *
+ * @param moments A pointer to an initialized accumulator.
+ * @param x The new value to incorporate into the running statistics.
+ * @param w The weight of the new value `x`.
+ */
+inline void incstats_moments_update(incstats_moments *moments, double x, 
+double w) {
+    incstats_central_moment(x, w, incstats_moments_buffer(moments), 
+                            moments->p);
+}
+
+/**
+ * @brief Finalizes the central moments held by `moments`.
+ *
+ * @param results A pointer to an array of length p + 2, see 
+ * `incstats_central_moment_finalize` for the layout.
+ * @param moments A pointer to an initialized accumulator.
+ * @param standardize If true, the standardized central moments are returned.
+ */
+inline void incstats_moments_finalize(double *results, 
+incstats_moments *moments, bool standardize) {
+    incstats_central_moment_finalize(results, 
+                                     incstats_moments_buffer(moments), 
+                                     moments->p, standardize);
+}
+
+/**
+ * @brief Transfers the state and memory of `src` to `dst`.
+ *
+ * @param dst A pointer to an accumulator that does not own memory, i.e. it is
+ * uninitialized, freed or moved from.
+ * @param src A pointer to an initialized accumulator. Afterwards it is left 
+ * as an accumulator of order 0 that owns no memory.
+ */
+inline void incstats_moments_move(incstats_moments *dst, 
+incstats_moments *src) {
+    *dst = *src;
+    src->p = 0;
+    src->heap = NULL;
+    memset(src->storage, 0, sizeof(src->storage));
+}
+
+/**
+ * @brief Releases the memory owned by `moments`.
+ *
+ * @param moments A pointer to an initialized accumulator. Afterwards it is 
+ * left as an accumulator of order 0 that owns no memory.
+ */
+inline void incstats_moments_free(incstats_moments *moments) {
+    if(moments->heap != NULL) {
+        if(moments->allocator.deallocate != NULL) {
+            moments->allocator.deallocate(moments->heap, 
+                                          moments->allocator.context);
+        }
+        else {
+            free(moments->heap);
+        }
+    }
+    moments->p = 0;
+    moments->heap = NULL;
+}
+
+/**
+ * @brief The highest order for which `incstats_central_moment_kernel` 
+ * provides a specialized kernel.
+ */
+#define INCSTATS_KERNEL_MAX_ORDER 16
+
+/**
+ * @brief An update kernel with the signature of `incstats_kurtosis`, i.e. 
+ * a central moment update whose order is fixed.
+ */
+typedef void (*incstats_moment_kernel)(double x, double w, double *buffer);
+
+/**
+ * @brief Returns an update kernel specialized for central moments of order 
+ * `p`.
+ *
+ * The kernels are instances of `incstats_central_moment` compiled for a 
+ * constant order, so the loops over the moments and binomial coefficients are
+ * unrolled and the coefficients are folded into the code. This gives the speed
+ * of a fixed order update for orders that are only known at runtime.
+ * 
+ * @param p The order of the highest central moment to update.
+ * @param weighted If false, the returned kernel ignores its weight argument 
+ * and uses a weight of 1, which saves the corresponding multiplications.
+ * @return A kernel that behaves like `incstats_central_moment` with order `p`
+ * on a buffer of length p + 1 or NULL if `p` is smaller than 2 or larger than
+ * INCSTATS_KERNEL_MAX_ORDER.
+ */
+incstats_moment_kernel incstats_central_moment_kernel(uint64_t p, 
+                                                      bool weighted);
+
+/**
+ * @brief Updates the running mean, variance, skewness, and kurtosis of a 
+ * dataset and invalidates the cached results.
+ *
+ * This function behaves like `incstats_kurtosis`, but the buffer additionally
+ * caches the finalized results, so that repeated calls to 
+ * incstats_kurtosis_lazy_finalize without intermediate updates only copy
+ * the cached values.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param w The weight of the new value `x`.
+ * @param buffer A pointer to a double array of length 10:
+ *               - `buffer[0]` to `buffer[4]` hold the state of 
+ *                 `incstats_kurtosis`.
+ *               - `buffer[5]` is non-zero if the cache is valid.
+ *               - `buffer[6]` to `buffer[9]` hold the cached results.
+ * 
+ * @note The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_kurtosis_lazy(double x, double w, double *buffer) {
+    incstats_kurtosis(x, w, buffer);
+    buffer[5] = 0.0;
+}
+
+/**
+ * @brief Finalizes the computation of the running mean, variance, skewness, 
+ * and kurtosis, reusing cached results if the buffer did not change.
+ *
+ * @param results A pointer to an array of length 4, see
+ * `incstats_kurtosis_finalize` for the layout.
+ * @param buffer A pointer to a double array of length 10 used by 
+ * `incstats_kurtosis_lazy`.
+ * 
+ * @note Only the cache inside `buffer` is written, the running statistics 
+ * are left untouched, allowing multiple calls to the same buffer.
+ */
+inline void incstats_kurtosis_lazy_finalize(double *results, double *buffer) {
+    if(buffer[5] == 0.0) {
+        incstats_kurtosis_finalize(&buffer[6], buffer);
+        buffer[5] = 1.0;
+    }
+    memcpy(results, &buffer[6], 4 * sizeof(double));
+}
+
+/**
+ * @brief Updates the running central moments of a dataset and invalidates
+ * the cached results.
+ *
+ * This function behaves like `incstats_central_moment`, but the buffer 
+ * additionally caches the finalized results, so that repeated calls to
+ * incstats_central_moment_lazy_finalize without intermediate updates only
+ * copy the cached values.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param w The weight of the new value `x`.
+ * @param buffer A pointer to an array of doubles of length 2 * p + 4:
+ *               - `buffer[0]` to `buffer[p]` hold the state of 
+ *                 `incstats_central_moment`.
+ *               - `buffer[p + 1]` is 0 if the cache is invalid, 1 if it holds
+ *                 central moments and 2 if it holds standardized central 
+ *                 moments.
+ *               - `buffer[p + 2]` to `buffer[2 * p + 3]` hold the cached 
+ *                 results.
+ * @param p The order of the highest central moment to update. Must be at 
+ * least 1.
+ * 
+ * @note The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_central_moment_lazy(double x, double w, double *buffer, 
+uint64_t p) {
+    incstats_central_moment(x, w, buffer, p);
+    buffer[p + 1] = 0.0;
+}
+
+/**
+ * @brief Finalizes the computation of the running central moments, reusing
+ * cached results if the buffer did not change.
+ *
+ * @param results A pointer to an array of doubles of length p + 2, see 
+ * `incstats_central_moment_finalize` for the layout.
+ * @param buffer A pointer to an array of doubles of length 2 * p + 4 used by
+ * `incstats_central_moment_lazy`.
+ * @param p The order of the highest central moment to finalize.
+ * @param standardize If true, the standardized central moments are returned.
+ * 
+ * @note Only the cache inside `buffer` is written, the running statistics 
+ * are left untouched, allowing multiple calls to the same buffer.
+ */
+inline void incstats_central_moment_lazy_finalize(double *results, 
+double *buffer, uint64_t p, bool standardize) {
+    double state = standardize ? 2.0 : 1.0;
+
+    if(buffer[p + 1] != state) {
+        incstats_central_moment_finalize(&buffer[p + 2], buffer, p, 
+                                         standardize);
+        buffer[p + 1] = state;
+    }
+    memcpy(results, &buffer[p + 2], (p + 2) * sizeof(double));
+}
+
+/**
+ * @brief Finalizes an array of kurtosis buffers stored one after another.
+ *
+ * This function computes the same results as calling 
+ * `incstats_kurtosis_finalize` for every buffer, but shares one division per
+ * buffer and has no loop carried dependencies, so that the compiler can 
+ * vectorize it.
+ * 
+ * @param results A pointer to an array of length 4 * n. The results of the
+ * i-th buffer are stored at `results[4 * i]` to `results[4 * i + 3]`, see
+ * `incstats_kurtosis_finalize` for the layout.
+ * @param buffers A pointer to an array of length 5 * n holding n buffers 
+ * updated by `incstats_kurtosis`.
+ * @param n The number of buffers.
+ * 
+ * @note Disjoint ranges of buffers may be finalized concurrently from 
+ * several threads. This call is non-destructive.
+ */
+inline void incstats_kurtosis_finalize_bulk(double *results, 
+const double *buffers, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        const double *buffer = &buffers[5 * i];
+        double inverse_sum_w = 1.0 / buffer[0];
+        double variance = buffer[2] * inverse_sum_w;
+
+        results[4 * i] = buffer[1];
+        results[4 * i + 1] = variance;
+        results[4 * i + 2] = buffer[3] * inverse_sum_w / 
+                             (variance * sqrt(variance));
+        results[4 * i + 3] = buffer[4] * inverse_sum_w / 
+                             (variance * variance);
+    }
+}
+
+/**
+ * @brief Finalizes kurtosis buffers stored as a structure of arrays.
+ *
+ * This function computes the same results as 
+ * `incstats_kurtosis_finalize_bulk`, but the i-th entry of each buffer and 
+ * of each result is stored in a separate array, which lets the compiler use
+ * contiguous vector loads and stores.
+ * 
+ * @param results A pointer to 4 arrays of length n receiving the means, 
+ * variances, skewnesses and kurtoses.
+ * @param buffers A pointer to 5 arrays of length n, where `buffers[j][i]`
+ * holds the j-th entry of the i-th kurtosis buffer.
+ * @param n The number of buffers.
+ * 
+ * @note Disjoint ranges of buffers may be finalized concurrently from 
+ * several threads. The result arrays must not overlap the buffer arrays.
+ */
+inline void incstats_kurtosis_finalize_soa(double *const *results,
+const double *const *buffers, size_t n) {
+    double *mean = results[0];
+    double *variance = results[1];
+    double *skewness = results[2];
+    double *kurtosis = results[3];
+
+    for(size_t i = 0; i < n; i++) {
+        double inverse_sum_w = 1.0 / buffers[0][i];
+        double m2 = buffers[2][i] * inverse_sum_w;
+
+        mean[i] = buffers[1][i];
+        variance[i] = m2;
+        skewness[i] = buffers[3][i] * inverse_sum_w / (m2 * sqrt(m2));
+        kurtosis[i] = buffers[4][i] * inverse_sum_w / (m2 * m2);
+    }
+}
+
+/**
+ * @brief The number of values from which `incstats_histogram_u8` spreads 
+ * the values over partial histograms. Shorter inputs are counted directly,
+ * since clearing and merging the partial histograms would cost more than 
+ * the counting.
+ */
+#define INCSTATS_HISTOGRAM_SPLIT_LENGTH 512
+
+/**
+ * @brief Counts the occurrences of 8 bit values.
+ *
+ * This function adds the values `x` to a dense histogram with one bin per
+ * value. From INCSTATS_HISTOGRAM_SPLIT_LENGTH values on, the loop spreads 
+ * consecutive values over independent partial histograms, so that runs of 
+ * equal values do not serialize on the same counter.
+ * 
+ * @param x A pointer to an array of n values.
+ * @param n The number of values.
+ * @param counts A pointer to an array of length 256. `counts[v]` is 
+ * incremented by the number of occurrences of `v` in `x`.
+ * 
+ * @note The `counts` array is expected to be initialized to 0 before the 
+ * first use. The moments are obtained by 
+ * incstats_histogram_central_moment_finalize.
+ */
+inline void incstats_histogram_u8(const uint8_t *x, size_t n, 
+uint64_t *counts) {
+    uint64_t partial[4][256];
+    size_t i = 0;
+
+    if(n < INCSTATS_HISTOGRAM_SPLIT_LENGTH) {
+        for(; i < n; i++) {
+            counts[x[i]]++;
+        }
+        return;
+    }
+    memset(partial, 0, sizeof(partial));
+    for(; i + 4 <= n; i += 4) {
+        partial[0][x[i]]++;
+        partial[1][x[i + 1]]++;
+        partial[2][x[i + 2]]++;
+        partial[3][x[i + 3]]++;
+    }
+    for(; i < n; i++) {
+        partial[0][x[i]]++;
+    }
+    for(size_t j = 0; j < 256; j++) {
+        counts[j] += partial[0][j] + partial[1][j] + partial[2][j] + 
+                     partial[3][j];
+    }
+}
+
+/**
+ * @brief Counts the occurrences of 16 bit values.
+ *
+ * @param x A pointer to an array of n values.
+ * @param n The number of values.
+ * @param counts A pointer to an array of length 65536. `counts[v]` is 
+ * incremented by the number of occurrences of `v` in `x`.
+ * 
+ * @note The `counts` array is expected to be initialized to 0 before the 
+ * first use. The moments are obtained by 
+ * incstats_histogram_central_moment_finalize.
+ */
+inline void incstats_histogram_u16(const uint16_t *x, size_t n, 
+uint64_t *counts) {
+    for(size_t i = 0; i < n; i++) {
+        counts[x[i]]++;
+    }
+}
+
+/**
+ * @brief Merges two histograms.
+ *
+ * @param counts A pointer to an array of length `bins` which the counts of
+ * `other` are added to.
+ * @param other A pointer to an array of length `bins`, e.g. filled by another
+ * thread.
+ * @param bins The number of bins of both histograms.
+ */
+inline void incstats_histogram_merge(uint64_t *counts, const uint64_t *other,
+size_t bins) {
+    for(size_t i = 0; i < bins; i++) {
+        counts[i] += other[i];
+    }
+}
+
+/**
+ * @brief Computes the central moments of the values counted in a histogram.
+ *
+ * The bin with index v represents the value v. Since the counts are exact,
+ * the moments are computed in two passes over the bins, which is more 
+ * accurate than the running updates and costs O(bins * p) independent of the
+ * number of counted values.
+ * 
+ * @param results A pointer to an array of doubles of length p + 2, see 
+ * `incstats_central_moment_finalize` for the layout.
+ * @param counts A pointer to an array of length `bins`.
+ * @param bins The number of bins, e.g. 256 or 65536.
+ * @param p The order of the highest central moment to compute.
+ * @param standardize If true, the standardized central moments are returned.
+ * 
+ * @note The histogram must not be empty.
+ */
+inline void incstats_histogram_central_moment_finalize(double *results,
+const uint64_t *counts, size_t bins, uint64_t p, bool standardize) {
+    uint64_t total = 0;
+    double sum = 0.0;
+    double mean;
+
+    for(size_t i = 0; i < bins; i++) {
+        total += counts[i];
+        sum += (double)counts[i] * (double)i;
+    }
+    mean = sum / (double)total;
+    for(uint64_t k = 0; k < p + 1; k++) {
+        results[k] = 0.0;
+    }
+    for(size_t i = 0; i < bins; i++) {
+        double delta = (double)i - mean;
+        double term = (double)counts[i] * delta;
+
+        if(counts[i] == 0) {
+            continue;
+        }
+        for(uint64_t k = 2; k < p + 1; k++) {
+            term *= delta;
+            results[k] += term;
+        }
+    }
+    results[0] = 1.0;
+    results[1] = 0.0;
+    for(uint64_t k = 2; k < p + 1; k++) {
+        results[k] /= (double)total;
+    }
+    if(standardize) {
+        double variance = results[2];
+        for(uint64_t k = 0; k < p + 1; k++) {
+            results[k] = results[k] / incstats_pow(sqrt(variance), k);
+        }
+    }
+    results[p + 1] = mean;
+}
+
+/**
+ * @brief Run-length encodes a sequence of values.
+ *
+ * @param values A pointer to an array of length n receiving the value of 
+ * each run.
+ * @param counts A pointer to an array of length n receiving the length of
+ * each run.
+ * @param x A pointer to an array of n values.
+ * @param n The number of values.
+ * @return The number of runs written to `values` and `counts`.
+ */
+inline size_t incstats_rle_encode(double *values, double *counts, 
+const double *x, size_t n) {
+    size_t runs = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        if(runs > 0 && values[runs - 1] == x[i]) {
+            counts[runs - 1] += 1.0;
+        }
+        else {
+            values[runs] = x[i];
+            counts[runs] = 1.0;
+            runs++;
+        }
+    }
+    return runs;
+}
+
+/**
+ * @brief Updates the running mean with run-length encoded data.
+ *
+ * A run of `c` equal values `v` has no spread of its own, so it enters the
+ * statistics exactly like a single value `v` with weight `c`. The cost is 
+ * therefore proportional to the number of runs instead of the number of 
+ * values.
+ * 
+ * @param values A pointer to an array of n run values.
+ * @param counts A pointer to an array of n run lengths. A run of samples 
+ * with a common weight `w` may pass `w` times its length.
+ * @param n The number of runs.
+ * @param buffer A pointer to a double array of length 2 used by 
+ * `incstats_mean`.
+ */
+inline void incstats_mean_rle(const double *values, const double *counts, 
+size_t n, double *buffer) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_mean(values[i], counts[i], buffer);
+    }
+}
+
+/**
+ * @brief Updates the running mean and variance with run-length encoded data.
+ *
+ * @param values A pointer to an array of n run values.
+ * @param counts A pointer to an array of n run lengths.
+ * @param n The number of runs.
+ * @param buffer A pointer to a double array of length 3 used by 
+ * `incstats_variance`.
+ * 
+ * @note See incstats_mean_rle.
+ */
+inline void incstats_variance_rle(const double *values, const double *counts,
+size_t n, double *buffer) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_variance(values[i], counts[i], buffer);
+    }
+}
+
+/**
+ * @brief Updates the running mean, variance, and skewness with run-length
+ * encoded data.
+ *
+ * @param values A pointer to an array of n run values.
+ * @param counts A pointer to an array of n run lengths.
+ * @param n The number of runs.
+ * @param buffer A pointer to a double array of length 4 used by 
+ * `incstats_skewness`.
+ * 
+ * @note See incstats_mean_rle.
+ */
+inline void incstats_skewness_rle(const double *values, const double *counts,
+size_t n, double *buffer) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_skewness(values[i], counts[i], buffer);
+    }
+}
+
+/**
+ * @brief Updates the running mean, variance, skewness, and kurtosis with 
+ * run-length encoded data.
+ *
+ * @param values A pointer to an array of n run values.
+ * @param counts A pointer to an array of n run lengths.
+ * @param n The number of runs.
+ * @param buffer A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`.
+ * 
+ * @note See incstats_mean_rle.
+ */
+inline void incstats_kurtosis_rle(const double *values, const double *counts,
+size_t n, double *buffer) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_kurtosis(values[i], counts[i], buffer);
+    }
+}
+
+/**
+ * @brief Updates the running central moments with run-length encoded data.
+ *
+ * @param values A pointer to an array of n run values.
+ * @param counts A pointer to an array of n run lengths.
+ * @param n The number of runs.
+ * @param buffer A pointer to an array of doubles of length p + 1 used by 
+ * `incstats_central_moment`.
+ * @param p The order of the highest central moment to update.
+ * 
+ * @note See incstats_mean_rle.
+ */
+inline void incstats_central_moment_rle(const double *values, 
+const double *counts, size_t n, double *buffer, uint64_t p) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_central_moment(values[i], counts[i], buffer, p);
+    }
+}
+
+/**
+ * @brief Computes log(exp(a) + exp(b)) without overflow or underflow.
+ *
+ * @param a The first logarithm.
+ * @param b The second logarithm.
+ * @return The logarithm of the sum of exp(a) and exp(b).
+ */
+inline double incstats_log_add_exp(double a, double b) {
+    if(a < b) {
+        return b + log1p(exp(a - b));
+    }
+    return a + log1p(exp(b - a));
+}
+
+/**
+ * @brief Updates the running mean and variance of a dataset with a 
+ * log-weight.
+ *
+ * This function computes the same statistics as `incstats_variance` for the
+ * weight exp(log_w), but keeps the sum of weights as a logarithm and the 
+ * variance normalized by it. Only ratios of weights enter the update, so
+ * weights spanning the full range of doubles (e.g. 1e-300 to 1e300 in 
+ * importance sampling) neither overflow nor vanish.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param log_w The natural logarithm of the weight of the new value `x`.
+ * @param buffer A pointer to a double array of length 4:
+ *               - `buffer[0]` holds the number of updates.
+ *               - `buffer[1]` holds the logarithm of the sum of weights.
+ *               - `buffer[2]` holds the mean.
+ *               - `buffer[3]` holds the variance.
+ * 
+ * @note The results shall be finalized by incstats_variance_log_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_variance_log(double x, double log_w, double *buffer) {
+    // ratio is the share of the new weight in the new sum of weights and 
+    // complement the share of the old sum, both obtained from logarithms.
+    double ratio = 1.0;
+    double complement = 0.0;
+    double delta = x - buffer[2];
+
+    if(buffer[0] != 0.0) {
+        double log_sum_w = incstats_log_add_exp(buffer[1], log_w);
+        ratio = exp(log_w - log_sum_w);
+        complement = exp(buffer[1] - log_sum_w);
+        buffer[1] = log_sum_w;
+    }
+    else {
+        buffer[1] = log_w;
+    }
+    buffer[0] += 1.0;
+    buffer[2] = buffer[2] + ratio * delta;
+    buffer[3] = complement * (buffer[3] + ratio * delta * delta);
+}
+
+/**
+ * @brief Finalizes the computation of the running mean and variance with
+ * log-weights.
+ *
+ * @param results A pointer to an array of length 2, see 
+ * `incstats_variance_finalize` for the layout.
+ * @param buffer A pointer to a double array of length 4 used by 
+ * `incstats_variance_log`.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_variance_log_finalize(double *results, double *buffer) {
+    results[0] = buffer[2];
+    results[1] = buffer[3];
+}
+
+/**
+ * @brief Updates the running mean, variance, skewness, and kurtosis of a 
+ * dataset with a log-weight.
+ *
+ * This function computes the same statistics as `incstats_kurtosis` for the
+ * weight exp(log_w), with the sum of weights kept as a logarithm and the
+ * central moments normalized by it, see incstats_variance_log.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param log_w The natural logarithm of the weight of the new value `x`.
+ * @param buffer A pointer to a double array of length 6:
+ *               - `buffer[0]` holds the number of updates.
+ *               - `buffer[1]` holds the logarithm of the sum of weights.
+ *               - `buffer[2]` holds the mean.
+ *               - `buffer[3]` to `buffer[5]` hold the second to fourth 
+ *                 central moments.
+ * 
+ * @note The results shall be finalized by incstats_kurtosis_log_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_kurtosis_log(double x, double log_w, double *buffer) {
+    double ratio = 1.0;
+    double complement = 0.0;
+    double delta = x - buffer[2];
+    double delta_old;
+    double delta_new;
+
+    if(buffer[0] != 0.0) {
+        double log_sum_w = incstats_log_add_exp(buffer[1], log_w);
+        ratio = exp(log_w - log_sum_w);
+        complement = exp(buffer[1] - log_sum_w);
+        buffer[1] = log_sum_w;
+    }
+    else {
+        buffer[1] = log_w;
+    }
+    // Shifts of the old data and of x relative to the new mean.
+    delta_old = -ratio * delta;
+    delta_new = complement * delta;
+    buffer[5] = complement * (buffer[5] + 4.0 * buffer[4] * delta_old + 
+                6.0 * buffer[3] * delta_old * delta_old + 
+                incstats_pow(delta_old, 4)) + ratio * 
+                incstats_pow(delta_new, 4);
+    buffer[4] = complement * (buffer[4] + 3.0 * buffer[3] * delta_old + 
+                incstats_pow(delta_old, 3)) + ratio * 
+                incstats_pow(delta_new, 3);
+    buffer[3] = complement * (buffer[3] + delta_old * delta_old) + ratio * 
+                delta_new * delta_new;
+    buffer[2] = buffer[2] + ratio * delta;
+    buffer[0] += 1.0;
+}
+
+/**
+ * @brief Finalizes the computation of the running mean, variance, skewness, 
+ * and kurtosis with log-weights.
+ *
+ * @param results A pointer to an array of length 4, see 
+ * `incstats_kurtosis_finalize` for the layout.
+ * @param buffer A pointer to a double array of length 6 used by 
+ * `incstats_kurtosis_log`.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_kurtosis_log_finalize(double *results, double *buffer) {
+    results[0] = buffer[2];
+    results[1] = buffer[3];
+    results[2] = buffer[4] / (buffer[3] * sqrt(buffer[3]));
+    results[3] = buffer[5] / (buffer[3] * buffer[3]);
+}
+
+/**
+ * @brief Sums of weights below this threshold are rescaled by 
+ * `incstats_variance_decay` to keep its state out of the subnormal range.
+ */
+#define INCSTATS_DECAY_RESCALE_THRESHOLD 1e-150
+
+/**
+ * @brief The binary exponent by which `incstats_variance_decay` rescales its
+ * state.
+ */
+#define INCSTATS_DECAY_RESCALE_EXPONENT 500
+
+/**
+ * @brief The binary exponent of the scale beyond which 
+ * `incstats_variance_decay` keeps rescaling its state without raising the 
+ * exponent further. Past it the state is negligible against any nonzero 
+ * weight, so the exponent and its conversion to int stay bounded.
+ */
+#define INCSTATS_DECAY_MAX_EXPONENT 4096
+
+/**
+ * @brief Updates the exponentially decaying mean and variance of a dataset.
+ *
+ * Before `x` is incorporated, the weights of all previous values are 
+ * multiplied by `decay`. Decaying states and tiny weights would eventually 
+ * produce subnormal numbers, which are 10 to 100 times slower on many CPUs.
+ * The function therefore rescales the sum of weights and the sum of squares
+ * by a power of two once the sum of weights drops below 
+ * INCSTATS_DECAY_RESCALE_THRESHOLD, which leaves the results unchanged, 
+ * and flushes a subnormal sum of squares to zero. A weight that exceeds the 
+ * scaled state by more than 2^INCSTATS_DECAY_RESCALE_EXPONENT, e.g. after a 
+ * long stretch of zero weights, scales the state back down first, so the 
+ * scaled weight cannot overflow.
+ * 
+ * @param x The new value to incorporate into the running statistics.
+ * @param w The weight of the new value `x`.
+ * @param decay The factor in [0, 1] applied to the weights of all previous 
+ * values.
+ * @param buffer A pointer to a double array of length 4:
+ *               - `buffer[0]` holds the scaled sum of weights.
+ *               - `buffer[1]` holds the mean.
+ *               - `buffer[2]` holds the scaled weighted sum of squares.
+ *               - `buffer[3]` holds the binary exponent of the scale.
+ * 
+ * @note The results shall be finalized by incstats_variance_finalize, which
+ * only uses the first three entries. The `buffer` array is expected to be 
+ * initialized to 0 before use.
+ */
+inline void incstats_variance_decay(double x, double w, double decay, 
+double *buffer) {
+    double new_mean;
+
+    if(buffer[3] != 0.0 && w != 0.0) {
+        int exponent = (int)buffer[3];
+        int excess = ilogb(w) + exponent;
+
+        if(excess > INCSTATS_DECAY_RESCALE_EXPONENT) {
+            int shift = excess < exponent ? excess : exponent;
+
+            buffer[0] = ldexp(buffer[0], -shift);
+            buffer[2] = ldexp(buffer[2], -shift);
+            exponent -= shift;
+            buffer[3] = (double)exponent;
+        }
+        w = ldexp(w, exponent);
+    }
+    buffer[0] = decay * buffer[0] + w;
+    new_mean = buffer[1] + w / buffer[0] * (x - buffer[1]);
+    buffer[2] = decay * buffer[2] + w * (x - buffer[1]) * (x - new_mean);
+    buffer[1] = new_mean;
+    if(buffer[0] < INCSTATS_DECAY_RESCALE_THRESHOLD && buffer[0] > 0.0) {
+        buffer[0] = ldexp(buffer[0], INCSTATS_DECAY_RESCALE_EXPONENT);
+        buffer[2] = ldexp(buffer[2], INCSTATS_DECAY_RESCALE_EXPONENT);
+        if(buffer[3] < INCSTATS_DECAY_MAX_EXPONENT) {
+            buffer[3] += INCSTATS_DECAY_RESCALE_EXPONENT;
+        }
+    }
+    if(fabs(buffer[2]) < DBL_MIN) {
+        buffer[2] = 0.0;
+    }
+}
+
+/**
+ * @brief Updates the exponentially decaying mean and variance with a batch 
+ * of values.
+ *
+ * This function calls `incstats_variance_decay` for each value. On x86 the 
+ * flush-to-zero and denormals-are-zero modes are enabled for the duration of 
+ * the batch, so that subnormal intermediates cannot slow it down, and the 
+ * previous floating point mode is restored afterwards.
+ * 
+ * @param x A pointer to an array of n values.
+ * @param w A pointer to an array of n weights.
+ * @param n The number of values.
+ * @param decay The factor in [0, 1] applied to the weights of all previous 
+ * values before each update.
+ * @param buffer A pointer to a double array of length 4 used by 
+ * `incstats_variance_decay`.
+ */
+void incstats_variance_decay_batch(const double *x, const double *w, size_t n,
+                                   double decay, double *buffer);
+
+/**
+ * @brief Computes approximations of the sine and cosine of an angle.
+ *
+ * The angle is reduced to [-pi, pi] and the sine and cosine of half of it 
+ * are evaluated by polynomials, from which the double angle formulas give 
+ * the results. The function has no branches, so loops over it can be 
+ * vectorized. The absolute error is below 1e-10 for |x| < 1e6.
+ * 
+ * @param x The angle in radians.
+ * @param sine A pointer to a double receiving the sine of `x`.
+ * @param cosine A pointer to a double receiving the cosine of `x`.
+ */
+inline void incstats_fast_sincos(double x, double *sine, double *cosine) {
+    // 2 * pi split into the nearest double and the remainder.
+    const double two_pi_high = 6.28318530717958623200e+00;
+    const double two_pi_low = 2.44929359829470635445e-16;
+    double turns = floor(x * (1.0 / (2.0 * M_PI)) + 0.5);
+    double h = 0.5 * ((x - turns * two_pi_high) - turns * two_pi_low);
+    double h2 = h * h;
+    double s = h * (1.0 + h2 * (-1.0 / 6.0 + h2 * (1.0 / 120.0 + h2 * 
+               (-1.0 / 5040.0 + h2 * (1.0 / 362880.0 + h2 * 
+               (-1.0 / 39916800.0 + h2 * (1.0 / 6227020800.0 + h2 * 
+               (-1.0 / 1307674368000.0))))))));
+    double c = 1.0 + h2 * (-1.0 / 2.0 + h2 * (1.0 / 24.0 + h2 * 
+               (-1.0 / 720.0 + h2 * (1.0 / 40320.0 + h2 * 
+               (-1.0 / 3628800.0 + h2 * (1.0 / 479001600.0 + h2 * 
+               (-1.0 / 87178291200.0 + h2 * (1.0 / 20922789888000.0))))))));
+
+    *sine = 2.0 * s * c;
+    *cosine = 1.0 - 2.0 * s * s;
+}
+
+/**
+ * @brief Updates the running circular statistics of a set of angles.
+ *
+ * Angles cannot be averaged linearly, e.g. the mean of 359 and 1 degree is 0
+ * and not 180 degrees. This function therefore tracks the weighted means of
+ * the cosines and sines of the angles, i.e. the mean resultant vector.
+ * 
+ * @param theta The new angle in radians.
+ * @param w The weight of the new angle `theta`.
+ * @param buffer A pointer to a double array of length 3:
+ *               - `buffer[0]` holds the sum of weights.
+ *               - `buffer[1]` holds the mean cosine.
+ *               - `buffer[2]` holds the mean sine.
+ * 
+ * @note The results shall be finalized by incstats_circular_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_circular(double theta, double w, double *buffer) {
+    double ratio;
+
+    buffer[0] += w;
+    ratio = w / buffer[0];
+    buffer[1] = buffer[1] + ratio * (cos(theta) - buffer[1]);
+    buffer[2] = buffer[2] + ratio * (sin(theta) - buffer[2]);
+}
+
+/**
+ * @brief Merges the circular statistics of two sets of angles.
+ *
+ * @param buffer A pointer to a double array of length 3 used by 
+ * `incstats_circular`. It receives the statistics of both sets.
+ * @param other A pointer to a double array of length 3 used by 
+ * `incstats_circular`, e.g. by another thread.
+ */
+inline void incstats_circular_merge(double *buffer, const double *other) {
+    double ratio;
+
+    if(other[0] == 0.0) {
+        return;
+    }
+    buffer[0] += other[0];
+    ratio = other[0] / buffer[0];
+    buffer[1] = buffer[1] + ratio * (other[1] - buffer[1]);
+    buffer[2] = buffer[2] + ratio * (other[2] - buffer[2]);
+}
+
+/**
+ * @brief Updates the running circular statistics with a batch of angles.
+ *
+ * This function uses `incstats_fast_sincos` and accumulates the batch 
+ * without loop carried divisions before merging it into `buffer`, so that
+ * the compiler can vectorize the loop.
+ * 
+ * @param theta A pointer to an array of n angles in radians.
+ * @param w A pointer to an array of n weights.
+ * @param n The number of angles.
+ * @param buffer A pointer to a double array of length 3 used by 
+ * `incstats_circular`.
+ */
+inline void incstats_circular_batch(const double *theta, const double *w, 
+size_t n, double *buffer) {
+    double batch[3] = {0.0, 0.0, 0.0};
+
+    for(size_t i = 0; i < n; i++) {
+        double sine;
+        double cosine;
+
+        incstats_fast_sincos(theta[i], &sine, &cosine);
+        batch[0] += w[i];
+        batch[1] += w[i] * cosine;
+        batch[2] += w[i] * sine;
+    }
+    if(batch[0] != 0.0) {
+        batch[1] /= batch[0];
+        batch[2] /= batch[0];
+    }
+    incstats_circular_merge(buffer, batch);
+}
+
+/**
+ * @brief Finalizes the computation of the running circular statistics.
+ *
+ * @param results A pointer to an array of length 4 where the results will be
+ * stored:
+ *                - `results[0]` will store the mean direction in (-pi, pi].
+ *                - `results[1]` will store the mean resultant length in 
+ *                  [0, 1].
+ *                - `results[2]` will store the circular variance, i.e. 1 
+ *                  minus the mean resultant length.
+ *                - `results[3]` will store the circular standard deviation 
+ *                  sqrt(-2 ln(R)), where R is the mean resultant length.
+ * @param buffer A pointer to a double array of length 3.
+ * 
+ * @note This function should be used to finalize the results obtained by 
+ * `incstats_circular`. This call is non-destructive, allowing multiple calls
+ * to the same buffer.
+ */
+inline void incstats_circular_finalize(double *results, double *buffer) {
+    double length = sqrt(buffer[1] * buffer[1] + buffer[2] * buffer[2]);
+
+    results[0] = atan2(buffer[2], buffer[1]);
+    results[1] = length;
+    results[2] = 1.0 - length;
+    results[3] = sqrt(-2.0 * log(length));
+}
+
+/**
+ * @brief Computes the dot product of two vectors.
+ *
+ * @param a A pointer to an array of length n.
+ * @param b A pointer to an array of length n.
+ * @param n The length of the vectors.
+ * @return The sum of `a[i] * b[i]`.
+ */
+inline double incstats_dot(const double *a, const double *b, size_t n) {
+    double result = 0.0;
+
+    for(size_t i = 0; i < n; i++) {
+        result += a[i] * b[i];
+    }
+    return result;
+}
+
+/**
+ * @brief Adds a multiple of one vector to another.
+ *
+ * @param alpha The factor applied to `x`.
+ * @param x A pointer to an array of length n.
+ * @param y A pointer to an array of length n which `alpha * x` is added to.
+ * @param n The length of the vectors.
+ */
+inline void incstats_axpy(double alpha, const double *x, double *y, 
+size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        y[i] += alpha * x[i];
+    }
+}
+
+/**
+ * @brief Multiplies a vector by a scalar.
+ *
+ * @param alpha The factor applied to `x`.
+ * @param x A pointer to an array of length n which is scaled in place.
+ * @param n The length of the vector.
+ */
+inline void incstats_scal(double alpha, double *x, size_t n) {
+    for(size_t i = 0; i < n; i++) {
+        x[i] *= alpha;
+    }
+}
+
+/**
+ * @brief Updates the running mean of a dataset of vectors.
+ *
+ * This function applies the update of `incstats_mean` to every coordinate.
+ * 
+ * @param x A pointer to the new vector of length d.
+ * @param w The weight of the new vector `x`.
+ * @param buffer A pointer to a double array of length d + 1:
+ *               - `buffer[0]` holds the sum of weights.
+ *               - `buffer[1]` to `buffer[d]` hold the mean vector.
+ * @param d The dimension of the vectors.
+ * 
+ * @note The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_mean_vector(const double *x, double w, double *buffer,
+size_t d) {
+    double ratio;
+
+    buffer[0] += w;
+    ratio = w / buffer[0];
+    for(size_t i = 0; i < d; i++) {
+        buffer[i + 1] = buffer[i + 1] + ratio * (x[i] - buffer[i + 1]);
+    }
+}
+
+/**
+ * @brief Updates the running principal components of a dataset of vectors.
+ *
+ * This function tracks the `k` leading eigenvectors and eigenvalues of the
+ * weighted covariance matrix without storing the matrix, using candid 
+ * covariance-free incremental PCA (CCIPCA). Each new vector is centered with
+ * the running mean and successively projected onto the component estimates,
+ * deflating it before it is passed on to the next component. An update 
+ * costs O(k * d).
+ * 
+ * @param x A pointer to the new vector of length d.
+ * @param w The weight of the new vector `x`.
+ * @param buffer A pointer to a double array of length 1 + (k + 2) * d:
+ *               - `buffer[0]` to `buffer[d]` hold the state of 
+ *                 `incstats_mean_vector`.
+ *               - `buffer[d + 1 + j * d]` to `buffer[d + (j + 1) * d]` 
+ *                 hold the j-th component scaled by its eigenvalue.
+ *               - the last d entries are used as scratch space.
+ * @param d The dimension of the vectors.
+ * @param k The number of principal components to track, at most d.
+ * 
+ * @note The results shall be finalized by incstats_pca_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_pca(const double *x, double w, double *buffer, size_t d,
+size_t k) {
+    double *mean = &buffer[1];
+    double *residual = &buffer[1 + (k + 1) * d];
+    double ratio;
+    double scale;
+
+    // With ratio = w / W the weighted covariance obeys
+    // C' = (1 - ratio) * C + ratio * u * u^T with 
+    // u = sqrt(1 - ratio) * (x - mean).
+    buffer[0] += w;
+    ratio = w / buffer[0];
+    scale = sqrt(1.0 - ratio);
+    for(size_t i = 0; i < d; i++) {
+        residual[i] = scale * (x[i] - mean[i]);
+        mean[i] = mean[i] + ratio * (x[i] - mean[i]);
+    }
+    for(size_t j = 0; j < k; j++) {
+        double *component = &buffer[1 + (j + 1) * d];
+        double norm = sqrt(incstats_dot(component, component, d));
+        double projection;
+
+        // v' = (1 - ratio) * v + ratio * u * (u^T v / |v|). An empty 
+        // estimate starts in the direction of u.
+        if(norm > 0.0) {
+            projection = incstats_dot(residual, component, d) / norm;
+            incstats_scal(1.0 - ratio, component, d);
+        }
+        else {
+            projection = sqrt(incstats_dot(residual, residual, d));
+        }
+        incstats_axpy(ratio * projection, residual, component, d);
+        norm = sqrt(incstats_dot(component, component, d));
+        if(norm == 0.0) {
+            break;
+        }
+        // Remove the direction of the component from u.
+        incstats_axpy(-incstats_dot(residual, component, d) / (norm * norm),
+                      component, residual, d);
+    }
+}
+
+/**
+ * @brief Updates the running principal components with a batch of vectors.
+ *
+ * @param x A pointer to an array of n vectors of length d stored one after
+ * another.
+ * @param w A pointer to an array of n weights.
+ * @param n The number of vectors.
+ * @param buffer A pointer to a double array of length 1 + (k + 2) * d used 
+ * by `incstats_pca`.
+ * @param d The dimension of the vectors.
+ * @param k The number of principal components to track.
+ */
+inline void incstats_pca_batch(const double *x, const double *w, size_t n,
+double *buffer, size_t d, size_t k) {
+    for(size_t i = 0; i < n; i++) {
+        incstats_pca(&x[i * d], w[i], buffer, d, k);
+    }
+}
+
+/**
+ * @brief Finalizes the computation of the running principal components.
+ *
+ * @param results A pointer to an array of length k * (d + 1) where the 
+ * results will be stored:
+ *                - `results[0]` to `results[k - 1]` will store the 
+ *                  eigenvalues of the covariance matrix.
+ *                - `results[k + j * d]` to `results[k + (j + 1) * d - 1]`
+ *                  will store the j-th principal component as unit vector.
+ * @param buffer A pointer to a double array of length 1 + (k + 2) * d used 
+ * by `incstats_pca`.
+ * @param d The dimension of the vectors.
+ * @param k The number of principal components.
+ * 
+ * @note The mean vector is stored in `buffer[1]` to `buffer[d]`. This call
+ * is non-destructive, allowing multiple calls to the same buffer.
+ */
+inline void incstats_pca_finalize(double *results, double *buffer, size_t d,
+size_t k) {
+    for(size_t j = 0; j < k; j++) {
+        const double *component = &buffer[1 + (j + 1) * d];
+        double norm = sqrt(incstats_dot(component, component, d));
+
+        results[j] = norm;
+        for(size_t i = 0; i < d; i++) {
+            results[k + j * d + i] = norm > 0.0 ? component[i] / norm : 0.0;
+        }
+    }
+}
+
+/**
+ * @brief Updates the running mean and the Cholesky factor of the covariance
+ * matrix of a dataset of vectors.
+ *
+ * This function maintains the lower triangular matrix L with L * L^T equal 
+ * to the weighted covariance matrix. A new vector changes the covariance by
+ * a scaled rank-1 term, which is folded into L with Givens rotations in 
+ * O(d^2) instead of refactoring the matrix in O(d^3). The columns of L are
+ * stored contiguously, so the inner loops run over consecutive memory.
+ * 
+ * @param x A pointer to the new vector of length d.
+ * @param w The weight of the new vector `x`.
+ * @param buffer A pointer to a double array of length 1 + (d + 2) * d:
+ *               - `buffer[0]` to `buffer[d]` hold the state of 
+ *                 `incstats_mean_vector`.
+ *               - `buffer[d + 1 + j * d + i]` holds the entry of L in row i
+ *                 and column j for i >= j.
+ *               - the last d entries are used as scratch space.
+ * @param d The dimension of the vectors.
+ * 
+ * @note Vectors are scored by incstats_mahalanobis_score. The `buffer` array
+ * is expected to be initialized to 0 before use.
+ */
+inline void incstats_mahalanobis(const double *x, double w, double *buffer,
+size_t d) {
+    double *mean = &buffer[1];
+    double *factor = &buffer[1 + d];
+    double *update = &buffer[1 + (d + 1) * d];
+    double ratio;
+    double scale;
+    double shift;
+
+    // C' = (1 - ratio) * (C + ratio * delta * delta^T), so
+    // L' = sqrt(1 - ratio) * rank1_update(L, sqrt(ratio) * delta).
+    buffer[0] += w;
+    ratio = w / buffer[0];
+    scale = sqrt(1.0 - ratio);
+    shift = sqrt(ratio);
+    for(size_t i = 0; i < d; i++) {
+        update[i] = shift * (x[i] - mean[i]);
+        mean[i] = mean[i] + ratio * (x[i] - mean[i]);
+    }
+    for(size_t j = 0; j < d; j++) {
+        double *column = &factor[j * d];
+        double diagonal = hypot(column[j], update[j]);
+        double c;
+        double s;
+
+        if(diagonal == 0.0) {
+            continue;
+        }
+        c = column[j] / diagonal;
+        s = update[j] / diagonal;
+        column[j] = scale * diagonal;
+        for(size_t i = j + 1; i < d; i++) {
+            double entry = column[i];
+            column[i] = scale * (c * entry + s * update[i]);
+            update[i] = c * update[i] - s * entry;
+        }
+    }
+}
+
+/**
+ * @brief Computes the Mahalanobis distance of a vector to the running 
+ * distribution.
+ *
+ * The distance sqrt((x - mean)^T * C^-1 * (x - mean)) is obtained from a 
+ * forward substitution with the Cholesky factor in O(d^2).
+ * 
+ * @param x A pointer to the vector of length d to score.
+ * @param buffer A pointer to a double array of length 1 + (d + 2) * d used 
+ * by `incstats_mahalanobis`.
+ * @param d The dimension of the vectors.
+ * @return The Mahalanobis distance of `x`. It is infinite or NaN as long as
+ * the covariance matrix is singular, e.g. before d + 1 vectors were added.
+ * 
+ * @note Only the scratch space of `buffer` is written.
+ */
+inline double incstats_mahalanobis_score(const double *x, double *buffer, 
+size_t d) {
+    const double *mean = &buffer[1];
+    const double *factor = &buffer[1 + d];
+    double *solution = &buffer[1 + (d + 1) * d];
+
+    for(size_t i = 0; i < d; i++) {
+        solution[i] = x[i] - mean[i];
+    }
+    for(size_t j = 0; j < d; j++) {
+        const double *column = &factor[j * d];
+
+        solution[j] /= column[j];
+        for(size_t i = j + 1; i < d; i++) {
+            solution[i] -= column[i] * solution[j];
+        }
+    }
+    return sqrt(incstats_dot(solution, solution, d));
+}
+
+/**
+ * @brief Finalizes the running mean and covariance matrix tracked by 
+ * `incstats_mahalanobis`.
+ *
+ * @param results A pointer to an array of length d * (d + 1) where the 
+ * results will be stored:
+ *                - `results[0]` to `results[d - 1]` will store the mean.
+ *                - `results[d + i * d + j]` will store the covariance of the
+ *                  i-th and j-th coordinate.
+ * @param buffer A pointer to a double array of length 1 + (d + 2) * d used 
+ * by `incstats_mahalanobis`.
+ * @param d The dimension of the vectors.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_mahalanobis_finalize(double *results, double *buffer,
+size_t d) {
+    const double *factor = &buffer[1 + d];
+
+    memcpy(results, &buffer[1], d * sizeof(double));
+    for(size_t i = 0; i < d; i++) {
+        for(size_t j = 0; j <= i; j++) {
+            double covariance = 0.0;
+
+            for(size_t l = 0; l <= j; l++) {
+                covariance += factor[l * d + i] * factor[l * d + j];
+            }
+            results[d + i * d + j] = covariance;
+            results[d + j * d + i] = covariance;
+        }
+    }
+}
+
+/**
+ * @brief Computes the position of an entry of a symmetric tensor in packed
+ * storage.
+ *
+ * Symmetric tensors of order up to 4 are stored with one entry per multiset
+ * of indices. The entry for the indices i <= j <= k <= l is stored at 
+ * i + j(j+1)/2 + k(k+1)(k+2)/6 + l(l+1)(l+2)(l+3)/24 (omitting the terms 
+ * beyond the order), which does not depend on the dimension. A tensor of 
+ * order p and dimension d has (d + p - 1 choose p) entries.
+ * 
+ * @param indices A pointer to an array of `order` indices in any order.
+ * @param order The order of the tensor, between 1 and 4.
+ * @return The position of the entry in packed storage.
+ */
+inline size_t incstats_symmetric_index(const size_t *indices, size_t order) {
+    size_t sorted[4];
+    size_t index = 0;
+    size_t simplex = 1;
+
+    for(size_t i = 0; i < order; i++) {
+        size_t j = i;
+        for(; j > 0 && sorted[j - 1] > indices[i]; j--) {
+            sorted[j] = sorted[j - 1];
+        }
+        sorted[j] = indices[i];
+    }
+    for(size_t i = 0; i < order; i++) {
+        // simplex becomes (sorted[i] + i choose i + 1).
+        simplex = sorted[i];
+        for(size_t j = 1; j <= i; j++) {
+            simplex = simplex * (sorted[i] + j) / (j + 1);
+        }
+        index += simplex;
+    }
+    return index;
+}
+
+/**
+ * @brief Updates the running mean, covariance, co-skewness, and co-kurtosis
+ * of a dataset of vectors.
+ *
+ * This function extends the recurrence of `incstats_kurtosis` to the tensors
+ * of second, third and fourth order cross moments. The tensors are symmetric,
+ * so only their unique entries are stored, see incstats_symmetric_index. For 
+ * fixed j, k and l the entries with i <= j are contiguous, which lets the 
+ * compiler vectorize the innermost loops of the rank-1 tensor updates.
+ * 
+ * @param x A pointer to the new vector of length d.
+ * @param w The weight of the new vector `x`.
+ * @param buffer A pointer to a double array of length 
+ * 1 + 2 * d + s2 + s3 + s4 with s2 = d(d+1)/2, s3 = d(d+1)(d+2)/6 and 
+ * s4 = d(d+1)(d+2)(d+3)/24:
+ *               - `buffer[0]` to `buffer[d]` hold the state of 
+ *                 `incstats_mean_vector`.
+ *               - the next s2, s3 and s4 entries hold the packed sums of 
+ *                 second, third and fourth order cross products of the 
+ *                 deviations from the mean.
+ *               - the last d entries are used as scratch space.
+ * @param d The dimension of the vectors.
+ * 
+ * @note The results shall be finalized by incstats_comoment_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_comoment(const double *x, double w, double *buffer, 
+size_t d) {
+    size_t s2 = d * (d + 1) / 2;
+    size_t s3 = s2 * (d + 2) / 3;
+    size_t s4 = s3 * (d + 3) / 4;
+    double *mean = &buffer[1];
+    double *m2 = &buffer[1 + d];
+    double *m3 = &m2[s2];
+    double *m4 = &m3[s3];
+    double *delta = &m4[s4];
+    double sum_w = buffer[0];
+    double new_sum_w = sum_w + w;
+    double ratio = w / new_sum_w;
+    double ratio2 = ratio * ratio;
+    double c2 = sum_w * ratio;
+    double c3 = c2 * (sum_w - w) / new_sum_w;
+    double c4 = c2 * (sum_w * sum_w - sum_w * w + w * w) / 
+                (new_sum_w * new_sum_w);
+
+    for(size_t i = 0; i < d; i++) {
+        delta[i] = x[i] - mean[i];
+    }
+    // The fourth order sums need the old second and third order sums, the
+    // third order sums the old second order sums. Terms that do not depend
+    // on the innermost index i are hoisted out of its loop.
+    for(size_t l = 0, t4 = 0; l < d; t4 += (l + 1) * (l + 2) * (l + 3) / 6,
+        l++) {
+        size_t t2l = l * (l + 1) / 2;
+        size_t t3l = t2l * (l + 2) / 3;
+        for(size_t k = 0, t3 = 0; k <= l; t3 += (k + 1) * (k + 2) / 2, k++) {
+            size_t t2k = k * (k + 1) / 2;
+            double dkl = delta[k] * delta[l];
+            for(size_t j = 0, t2 = 0; j <= k; t2 += j + 1, j++) {
+                double *entry = &m4[t2 + t3 + t4];
+                double djkl = delta[j] * dkl;
+                double outer = ratio2 * (m2[j + t2k] * delta[l] + 
+                               m2[j + t2l] * delta[k] + m2[k + t2l] * 
+                               delta[j]) - ratio * m3[j + t2k + t3l];
+                for(size_t i = 0; i <= j; i++) {
+                    entry[i] += c4 * delta[i] * djkl + outer * delta[i] + 
+                                ratio2 * (m2[i + t2] * dkl + m2[i + t2k] * 
+                                delta[j] * delta[l] + m2[i + t2l] * 
+                                delta[j] * delta[k]) - ratio * 
+                                (m3[i + t2 + t3] * delta[l] + 
+                                m3[i + t2 + t3l] * delta[k] + 
+                                m3[i + t2k + t3l] * delta[j]);
+                }
+            }
+        }
+    }
+    for(size_t k = 0, t3 = 0; k < d; t3 += (k + 1) * (k + 2) / 2, k++) {
+        size_t t2k = k * (k + 1) / 2;
+        for(size_t j = 0, t2 = 0; j <= k; t2 += j + 1, j++) {
+            double *entry = &m3[t2 + t3];
+            double djk = delta[j] * delta[k];
+            double outer = -ratio * m2[j + t2k];
+            for(size_t i = 0; i <= j; i++) {
+                entry[i] += c3 * delta[i] * djk + outer * delta[i] - ratio *
+                            (m2[i + t2] * delta[k] + m2[i + t2k] * delta[j]);
+            }
+        }
+    }
+    for(size_t j = 0, t2 = 0; j < d; t2 += j + 1, j++) {
+        double *entry = &m2[t2];
+        for(size_t i = 0; i <= j; i++) {
+            entry[i] += c2 * delta[i] * delta[j];
+        }
+    }
+    buffer[0] = new_sum_w;
+    incstats_axpy(ratio, delta, mean, d);
+}
+
+/**
+ * @brief Merges the co-moments of two datasets of vectors.
+ *
+ * This function combines two buffers updated by `incstats_comoment`, e.g.
+ * by different threads, using the pairwise update formulas for cross 
+ * moments.
+ * 
+ * @param buffer A pointer to a double array used by `incstats_comoment`. It 
+ * receives the co-moments of both datasets.
+ * @param other A pointer to a double array used by `incstats_comoment`. Only
+ * its scratch space is written.
+ * @param d The dimension of the vectors.
+ */
+inline void incstats_comoment_merge(double *buffer, double *other, size_t d) {
+    size_t s2 = d * (d + 1) / 2;
+    size_t s3 = s2 * (d + 2) / 3;
+    size_t s4 = s3 * (d + 3) / 4;
+    double *mean = &buffer[1];
+    double *m2 = &buffer[1 + d];
+    double *m3 = &m2[s2];
+    double *m4 = &m3[s3];
+    const double *m2b = &other[1 + d];
+    const double *m3b = &m2b[s2];
+    const double *m4b = &m3b[s3];
+    double *delta = &other[1 + d + s2 + s3 + s4];
+    double na = buffer[0];
+    double nb = other[0];
+    double n = na + nb;
+    double a2;
+    double b2;
+    double a3;
+    double b3;
+    double c2;
+    double c3;
+    double c4;
+
+    if(nb == 0.0) {
+        return;
+    }
+    // Second order sums enter the fourth order terms as 
+    // (na^2 * m2b + nb^2 * m2) / n^2, third order sums as 
+    // (na * m3b - nb * m3) / n, see Pebay (2008).
+    a2 = na * na / (n * n);
+    b2 = nb * nb / (n * n);
+    a3 = na / n;
+    b3 = nb / n;
+    c2 = na * nb / n;
+    c3 = c2 * (na - nb) / n;
+    c4 = c2 * (na * na - na * nb + nb * nb) / (n * n);
+    for(size_t i = 0; i < d; i++) {
+        delta[i] = other[1 + i] - mean[i];
+    }
+    for(size_t l = 0, t4 = 0; l < d; t4 += (l + 1) * (l + 2) * (l + 3) / 6,
+        l++) {
+        size_t t2l = l * (l + 1) / 2;
+        size_t t3l = t2l * (l + 2) / 3;
+        for(size_t k = 0, t3 = 0; k <= l; t3 += (k + 1) * (k + 2) / 2, k++) {
+            size_t t2k = k * (k + 1) / 2;
+            double dkl = delta[k] * delta[l];
+            for(size_t j = 0, t2 = 0; j <= k; t2 += j + 1, j++) {
+                size_t e = t2 + t3 + t4;
+                double djkl = delta[j] * dkl;
+                double outer = (a2 * m2b[j + t2k] + b2 * m2[j + t2k]) * 
+                               delta[l] + (a2 * m2b[j + t2l] + b2 * 
+                               m2[j + t2l]) * delta[k] + (a2 * m2b[k + t2l] +
+                               b2 * m2[k + t2l]) * delta[j] + 
+                               a3 * m3b[j + t2k + t3l] - 
+                               b3 * m3[j + t2k + t3l];
+                for(size_t i = 0; i <= j; i++) {
+                    m4[e + i] += m4b[e + i] + c4 * delta[i] * djkl + 
+                                 outer * delta[i] + 
+                                 (a2 * m2b[i + t2] + b2 * m2[i + t2]) * dkl + 
+                                 (a2 * m2b[i + t2k] + b2 * m2[i + t2k]) * 
+                                 delta[j] * delta[l] + 
+                                 (a2 * m2b[i + t2l] + b2 * m2[i + t2l]) * 
+                                 delta[j] * delta[k] + 
+                                 (a3 * m3b[i + t2 + t3] - b3 * 
+                                 m3[i + t2 + t3]) * delta[l] + 
+                                 (a3 * m3b[i + t2 + t3l] - b3 * 
+                                 m3[i + t2 + t3l]) * delta[k] + 
+                                 (a3 * m3b[i + t2k + t3l] - b3 * 
+                                 m3[i + t2k + t3l]) * delta[j];
+                }
+            }
+        }
+    }
+    for(size_t k = 0, t3 = 0; k < d; t3 += (k + 1) * (k + 2) / 2, k++) {
+        size_t t2k = k * (k + 1) / 2;
+        for(size_t j = 0, t2 = 0; j <= k; t2 += j + 1, j++) {
+            size_t e = t2 + t3;
+            double djk = delta[j] * delta[k];
+            double outer = a3 * m2b[j + t2k] - b3 * m2[j + t2k];
+            for(size_t i = 0; i <= j; i++) {
+                m3[e + i] += m3b[e + i] + c3 * delta[i] * djk + 
+                             outer * delta[i] + (a3 * m2b[i + t2] - b3 * 
+                             m2[i + t2]) * delta[k] + (a3 * m2b[i + t2k] - 
+                             b3 * m2[i + t2k]) * delta[j];
+            }
+        }
+    }
+    for(size_t j = 0, t2 = 0; j < d; t2 += j + 1, j++) {
+        for(size_t i = 0; i <= j; i++) {
+            m2[i + t2] += m2b[i + t2] + c2 * delta[i] * delta[j];
+        }
+    }
+    buffer[0] = n;
+    incstats_axpy(b3, delta, mean, d);
+}
+
+/**
+ * @brief Finalizes the computation of the running co-moments.
+ *
+ * @param results A pointer to an array of length d + s2 + s3 + s4 (see 
+ * incstats_comoment) where the results will be stored:
+ *                - the first d entries will store the mean.
+ *                - the next s2 entries will store the packed covariance 
+ *                  matrix.
+ *                - the next s3 entries will store the packed co-skewness 
+ *                  tensor.
+ *                - the last s4 entries will store the packed co-kurtosis 
+ *                  tensor.
+ * @param buffer A pointer to a double array used by `incstats_comoment`.
+ * @param d The dimension of the vectors.
+ * @param standardize If true, the co-skewness and co-kurtosis entries are 
+ * divided by the product of the standard deviations of their coordinates.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_comoment_finalize(double *results, double *buffer, 
+size_t d, bool standardize) {
+    size_t s2 = d * (d + 1) / 2;
+    size_t s3 = s2 * (d + 2) / 3;
+    size_t s4 = s3 * (d + 3) / 4;
+    double *covariance = &results[d];
+    double *coskewness = &covariance[s2];
+    double *cokurtosis = &coskewness[s3];
+    size_t e = 0;
+
+    memcpy(results, &buffer[1], d * sizeof(double));
+    for(size_t i = 0; i < s2 + s3 + s4; i++) {
+        results[d + i] = buffer[1 + d + i] / buffer[0];
+    }
+    if(!standardize) {
+        return;
+    }
+    for(size_t k = 0; k < d; k++) {
+        for(size_t j = 0; j <= k; j++) {
+            for(size_t i = 0; i <= j; i++, e++) {
+                coskewness[e] /= sqrt(covariance[i + i * (i + 1) / 2] * 
+                                 covariance[j + j * (j + 1) / 2] * 
+                                 covariance[k + k * (k + 1) / 2]);
+            }
+        }
+    }
+    e = 0;
+    for(size_t l = 0; l < d; l++) {
+        for(size_t k = 0; k <= l; k++) {
+            for(size_t j = 0; j <= k; j++) {
+                for(size_t i = 0; i <= j; i++, e++) {
+                    cokurtosis[e] /= sqrt(covariance[i + i * (i + 1) / 2] * 
+                                     covariance[j + j * (j + 1) / 2] * 
+                                     covariance[k + k * (k + 1) / 2] * 
+                                     covariance[l + l * (l + 1) / 2]);
+                }
+            }
+        }
+    }
+}
+
+/**
+ * @brief Merges the running mean and variance of two datasets.
+ *
+ * @param buffer A pointer to a double array of length 3 used by 
+ * `incstats_variance`. It receives the statistics of both datasets.
+ * @param other A pointer to a double array of length 3 used by 
+ * `incstats_variance`, e.g. by another thread.
+ */
+inline void incstats_variance_merge(double *buffer, const double *other) {
+    double sum_w = buffer[0] + other[0];
+    double delta = other[1] - buffer[1];
+
+    if(other[0] == 0.0) {
+        return;
+    }
+    buffer[2] = buffer[2] + other[2] + delta * delta * buffer[0] * other[0] /
+                sum_w;
+    buffer[1] = buffer[1] + other[0] / sum_w * delta;
+    buffer[0] = sum_w;
+}
+
+/**
+ * @brief Merges the running mean, variance, skewness and kurtosis of two 
+ * datasets.
+ *
+ * This function combines the sums of powers of the deviations with the 
+ * pairwise formulas of Pebay (2008), so that datasets accumulated 
+ * separately, e.g. by several threads, yield the statistics of their union.
+ * 
+ * @param buffer A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`. It receives the statistics of both datasets.
+ * @param other A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`.
+ */
+inline void incstats_kurtosis_merge(double *buffer, const double *other) {
+    double n_a = buffer[0];
+    double n_b = other[0];
+    double n = n_a + n_b;
+    double delta = other[1] - buffer[1];
+    double delta_n = delta / n;
+    double m2 = buffer[2];
+    double m3 = buffer[3];
+
+    if(n_b == 0.0) {
+        return;
+    }
+    buffer[4] = buffer[4] + other[4] + delta * delta_n * delta_n * delta_n * 
+                n_a * n_b * (n_a * n_a - n_a * n_b + n_b * n_b) + 
+                6.0 * delta_n * delta_n * (n_a * n_a * other[2] + 
+                n_b * n_b * m2) + 4.0 * delta_n * (n_a * other[3] - 
+                n_b * m3);
+    buffer[3] = m3 + other[3] + delta * delta_n * delta_n * n_a * n_b * 
+                (n_a - n_b) + 3.0 * delta_n * (n_a * other[2] - n_b * m2);
+    buffer[2] = m2 + other[2] + delta * delta_n * n_a * n_b;
+    buffer[1] = buffer[1] + n_b * delta_n;
+    buffer[0] = n;
+}
+
+/**
+ * @brief The lower bound of the component variances of `incstats_gmm` 
+ * relative to the variance of all data.
+ */
+#define INCSTATS_GMM_VARIANCE_FLOOR 1e-6
+
+/**
+ * @brief Updates an online Gaussian mixture model of a dataset.
+ *
+ * This function fits a mixture of `k` one dimensional Gaussians with online
+ * EM: the responsibilities of the components for `x` are computed from the 
+ * current fit and each component is then updated like `incstats_variance` 
+ * with the weight `w` times its responsibility. The components are stored as
+ * structure of arrays, so that the loops over them can be vectorized.
+ * 
+ * @param x The new value to incorporate into the model.
+ * @param w The weight of the new value `x`.
+ * @param buffer A pointer to a double array of length 3 + 4 * k:
+ *               - `buffer[0]` to `buffer[2]` hold the state of 
+ *                 `incstats_variance` for all data.
+ *               - `buffer[3 + c]`, `buffer[3 + k + c]` and 
+ *                 `buffer[3 + 2 * k + c]` hold the sum of weights, the mean 
+ *                 and the weighted sum of squares of component c.
+ *               - the last k entries are used as scratch space.
+ * @param k The number of components.
+ * 
+ * @note The results shall be finalized by incstats_gmm_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ * The first `k` values seed the components. Like any EM fit, the model 
+ * converges to a local optimum, so the seeds should cover the modes of the 
+ * data, e.g. by feeding one representative per mode first.
+ */
+inline void incstats_gmm(double x, double w, double *buffer, uint64_t k) {
+    double *sum_w = &buffer[3];
+    double *mean = &buffer[3 + k];
+    double *m2 = &buffer[3 + 2 * k];
+    double *responsibility = &buffer[3 + 3 * k];
+    double prior;
+    double floor;
+    double max_log = -INFINITY;
+    double total = 0.0;
+
+    incstats_variance(x, w, buffer);
+    for(uint64_t c = 0; c < k; c++) {
+        if(sum_w[c] == 0.0) {
+            sum_w[c] = w;
+            mean[c] = x;
+            m2[c] = 0.0;
+            return;
+        }
+    }
+    prior = buffer[2] / buffer[0] / (double)(k * k);
+    floor = INCSTATS_GMM_VARIANCE_FLOOR * buffer[2] / buffer[0];
+    floor = floor > DBL_MIN ? floor : DBL_MIN;
+    for(uint64_t c = 0; c < k; c++) {
+        // A pseudo-observation of weight w with a share of the variance of 
+        // all data keeps freshly seeded components from collapsing onto 
+        // their seed.
+        double variance = (m2[c] + prior * w) / (sum_w[c] + w);
+        variance = variance > floor ? variance : floor;
+        responsibility[c] = log(sum_w[c]) - 0.5 * log(variance) - 0.5 * 
+                            (x - mean[c]) * (x - mean[c]) / variance;
+        max_log = responsibility[c] > max_log ? responsibility[c] : max_log;
+    }
+    for(uint64_t c = 0; c < k; c++) {
+        responsibility[c] = exp(responsibility[c] - max_log);
+        total += responsibility[c];
+    }
+    for(uint64_t c = 0; c < k; c++) {
+        double weight = w * responsibility[c] / total;
+        double new_mean;
+
+        sum_w[c] += weight;
+        new_mean = mean[c] + weight / sum_w[c] * (x - mean[c]);
+        m2[c] += weight * (x - mean[c]) * (x - new_mean);
+        mean[c] = new_mean;
+    }
+}
+
+/**
+ * @brief Merges two online Gaussian mixture models.
+ *
+ * Models fitted on separate shards are seeded independently, so their 
+ * components are matched by the order of their means and merged like 
+ * `incstats_variance_merge`.
+ * 
+ * @param buffer A pointer to a double array of length 3 + 4 * k used by 
+ * `incstats_gmm`. It receives the merged model.
+ * @param other A pointer to a double array of length 3 + 4 * k used by 
+ * `incstats_gmm`.
+ * @param k The number of components of both models.
+ */
+inline void incstats_gmm_merge(double *buffer, const double *other, 
+uint64_t k) {
+    double *rank = &buffer[3 + 3 * k];
+
+    incstats_variance_merge(buffer, other);
+    // Ranks of the means with ties broken by the index.
+    for(uint64_t c = 0; c < k; c++) {
+        rank[c] = 0.0;
+        for(uint64_t j = 0; j < k; j++) {
+            if(buffer[3 + k + j] < buffer[3 + k + c] || 
+               (buffer[3 + k + j] == buffer[3 + k + c] && j < c)) {
+                rank[c] += 1.0;
+            }
+        }
+    }
+    for(uint64_t c = 0; c < k; c++) {
+        uint64_t other_rank = 0;
+
+        for(uint64_t j = 0; j < k; j++) {
+            if(other[3 + k + j] < other[3 + k + c] || 
+               (other[3 + k + j] == other[3 + k + c] && j < c)) {
+                other_rank++;
+            }
+        }
+        for(uint64_t j = 0; j < k; j++) {
+            if(rank[j] == (double)other_rank) {
+                double component[3] = {buffer[3 + j], buffer[3 + k + j], 
+                                       buffer[3 + 2 * k + j]};
+                double other_component[3] = {other[3 + c], other[3 + k + c], 
+                                             other[3 + 2 * k + c]};
+
+                if(component[0] == 0.0) {
+                    memcpy(component, other_component, sizeof(component));
+                }
+                else {
+                    incstats_variance_merge(component, other_component);
+                }
+                buffer[3 + j] = component[0];
+                buffer[3 + k + j] = component[1];
+                buffer[3 + 2 * k + j] = component[2];
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Finalizes an online Gaussian mixture model.
+ *
+ * @param results A pointer to an array of length 3 * k where the results 
+ * will be stored:
+ *                - `results[3 * c]` will store the mixing weight of 
+ *                  component c.
+ *                - `results[3 * c + 1]` will store the mean of component c.
+ *                - `results[3 * c + 2]` will store the variance of 
+ *                  component c.
+ * @param buffer A pointer to a double array of length 3 + 4 * k used by 
+ * `incstats_gmm`.
+ * @param k The number of components.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_gmm_finalize(double *results, double *buffer, 
+uint64_t k) {
+    double total = 0.0;
+
+    for(uint64_t c = 0; c < k; c++) {
+        total += buffer[3 + c];
+    }
+    for(uint64_t c = 0; c < k; c++) {
+        results[3 * c] = buffer[3 + c] / total;
+        results[3 * c + 1] = buffer[3 + k + c];
+        results[3 * c + 2] = buffer[3 + 2 * k + c] / buffer[3 + c];
+    }
+}
+
+/**
+ * @brief Assigns vectors to the nearest clusters of a k-means model.
+ *
+ * This function only reads `buffer`, so a batch can be split into slices 
+ * that are assigned by several threads at once before the model is updated 
+ * with `incstats_kmeans_update`. Clusters without weight have not been 
+ * seeded yet: the leading vectors of `x` are given to them one each, in the
+ * order of the clusters, and serve as their centroids for the remaining 
+ * vectors. Slices assigned at once on a model with empty clusters each seed 
+ * them with their own leading vectors, which the update then averages.
+ * 
+ * @param labels A pointer to an array of length n where the index of the 
+ * nearest cluster of every vector will be stored.
+ * @param x A pointer to an array of n vectors of length d stored one after
+ * another.
+ * @param n The number of vectors.
+ * @param buffer A pointer to a double array of length k * (1 + 2 * d) used 
+ * by `incstats_kmeans_update`.
+ * @param d The dimension of the vectors.
+ * @param k The number of clusters.
+ */
+inline void incstats_kmeans_assign(size_t *labels, const double *x, size_t n,
+const double *buffer, size_t d, size_t k) {
+    const double *sum_w = buffer;
+    const double *centroids = &buffer[k];
+    size_t empty = 0;
+
+    for(size_t i = 0; i < n; i++) {
+        const double *point = &x[i * d];
+        double best = INFINITY;
+        size_t label = 0;
+        size_t seed = 0;
+
+        while(empty < k && sum_w[empty] != 0.0) {
+            empty++;
+        }
+        if(empty < k) {
+            labels[i] = empty++;
+            continue;
+        }
+        for(size_t c = 0; c < k; c++) {
+            // All empty clusters are seeded here, the s-th with the s-th 
+            // vector.
+            const double *centroid = sum_w[c] != 0.0 ? &centroids[c * d] : 
+                                     &x[seed++ * d];
+            double distance = 0.0;
+
+            for(size_t j = 0; j < d; j++) {
+                double delta = point[j] - centroid[j];
+                distance += delta * delta;
+            }
+            if(distance < best) {
+                best = distance;
+                label = c;
+            }
+        }
+        labels[i] = label;
+    }
+}
+
+/**
+ * @brief Updates a mini-batch k-means model with assigned vectors.
+ *
+ * Every cluster holds the state of `incstats_variance` for each coordinate 
+ * of its vectors. Moving the centroid by w / (sum of weights) towards a new 
+ * vector is the per-center learning rate of mini-batch k-means 
+ * (Sculley, 2010), so the centroids are the means of the vectors assigned to
+ * them.
+ * 
+ * @param x A pointer to an array of n vectors of length d stored one after
+ * another.
+ * @param w A pointer to an array of n weights.
+ * @param labels A pointer to an array of n cluster indices computed by 
+ * `incstats_kmeans_assign` before the update.
+ * @param n The number of vectors.
+ * @param buffer A pointer to a double array of length k * (1 + 2 * d):
+ *               - `buffer[c]` holds the sum of weights of cluster c.
+ *               - `buffer[k + c * d]` to `buffer[k + (c + 1) * d - 1]` hold 
+ *                 the centroid of cluster c.
+ *               - `buffer[k + (k + c) * d]` to 
+ *                 `buffer[k + (k + c + 1) * d - 1]` hold the weighted sums 
+ *                 of squared deviations of cluster c.
+ * @param d The dimension of the vectors.
+ * @param k The number of clusters.
+ * 
+ * @note The results shall be finalized by incstats_kmeans_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_kmeans_update(const double *x, const double *w, 
+const size_t *labels, size_t n, double *buffer, size_t d, size_t k) {
+    for(size_t i = 0; i < n; i++) {
+        size_t c = labels[i];
+        double *centroid = &buffer[k + c * d];
+        double *m2 = &buffer[k + (k + c) * d];
+        double ratio;
+
+        buffer[c] += w[i];
+        ratio = w[i] / buffer[c];
+        for(size_t j = 0; j < d; j++) {
+            double delta = x[i * d + j] - centroid[j];
+            centroid[j] += ratio * delta;
+            m2[j] += w[i] * delta * (x[i * d + j] - centroid[j]);
+        }
+    }
+}
+
+/**
+ * @brief Updates a mini-batch k-means model with a batch of vectors.
+ *
+ * This function assigns the batch with `incstats_kmeans_assign` and then 
+ * applies `incstats_kmeans_update`. While there are clusters without weight,
+ * the leading vectors of the batch seed them one after another.
+ * 
+ * @param x A pointer to an array of n vectors of length d stored one after
+ * another.
+ * @param w A pointer to an array of n weights.
+ * @param labels A pointer to an array of length n where the cluster index 
+ * of every vector will be stored.
+ * @param n The number of vectors.
+ * @param buffer A pointer to a double array of length k * (1 + 2 * d) used 
+ * by `incstats_kmeans_update`.
+ * @param d The dimension of the vectors.
+ * @param k The number of clusters.
+ */
+inline void incstats_kmeans_batch(const double *x, const double *w, 
+size_t *labels, size_t n, double *buffer, size_t d, size_t k) {
+    incstats_kmeans_assign(labels, x, n, buffer, d, k);
+    incstats_kmeans_update(x, w, labels, n, buffer, d, k);
+}
+
+/**
+ * @brief Finalizes a mini-batch k-means model.
+ *
+ * @param results A pointer to an array of length k * (1 + 2 * d) where the
+ * results will be stored:
+ *                - `results[c * (1 + 2 * d)]` will store the sum of weights
+ *                  of cluster c.
+ *                - the next d entries will store its centroid.
+ *                - the next d entries will store the variances of its 
+ *                  coordinates.
+ * @param buffer A pointer to a double array of length k * (1 + 2 * d) used 
+ * by `incstats_kmeans_update`.
+ * @param d The dimension of the vectors.
+ * @param k The number of clusters.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_kmeans_finalize(double *results, double *buffer, 
+size_t d, size_t k) {
+    for(size_t c = 0; c < k; c++) {
+        double *result = &results[c * (1 + 2 * d)];
+
+        result[0] = buffer[c];
+        for(size_t j = 0; j < d; j++) {
+            result[1 + j] = buffer[k + c * d + j];
+            result[1 + d + j] = buffer[c] > 0.0 ? 
+                                buffer[k + (k + c) * d + j] / buffer[c] : 0.0;
+        }
+    }
+}
+
+/**
+ * @brief Computes the quantile function of the standard normal distribution.
+ *
+ * This function uses the rational approximations of Acklam, which have a 
+ * relative error below 1.15e-9, followed by one step of Halley's method 
+ * that brings the result to about machine precision.
+ * 
+ * @param p The probability in (0, 1).
+ * @return The value z with P(Z <= z) = p for a standard normal Z. Returns 
+ * -INFINITY for p = 0, INFINITY for p = 1 and NAN outside of [0, 1].
+ */
+inline double incstats_normal_quantile(double p) {
+    static const double a[6] = {-3.969683028665376e+01, 2.209460984245205e+02,
+                                -2.759285104469687e+02, 1.383577518672690e+02,
+                                -3.066479806614716e+01, 2.506628277459239e+00};
+    static const double b[5] = {-5.447609879822406e+01, 1.615858368580409e+02,
+                                -1.556989798598866e+02, 6.680131188771972e+01,
+                                -1.328068155288572e+01};
+    static const double c[6] = {-7.784894002430293e-03, -3.223964580411365e-01,
+                                -2.400758277161838e+00, -2.549732539343734e+00,
+                                4.374664141464968e+00, 2.938163982698783e+00};
+    static const double d[4] = {7.784695709041462e-03, 3.224671290700398e-01,
+                                2.445134137142996e+00, 3.754408661907416e+00};
+    double q;
+    double r;
+    double z;
+    double e;
+    double u;
+
+    if(!(p >= 0.0 && p <= 1.0)) {
+        return NAN;
+    }
+    if(p == 0.0) {
+        return -INFINITY;
+    }
+    if(p == 1.0) {
+        return INFINITY;
+    }
+    if(p < 0.02425) {
+        q = sqrt(-2.0 * log(p));
+        z = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + 
+            c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    else if(p > 1.0 - 0.02425) {
+        q = sqrt(-2.0 * log(1.0 - p));
+        z = -(((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + 
+             c[5]) / ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+    }
+    else {
+        q = p - 0.5;
+        r = q * q;
+        z = (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + 
+            a[5]) * q / (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + 
+            b[4]) * r + 1.0);
+    }
+    // Halley's method on the normal distribution function.
+    e = 0.5 * erfc(-z / M_SQRT2) - p;
+    u = e * sqrt(2.0 * M_PI) * exp(0.5 * z * z);
+    return z - u / (1.0 + 0.5 * z * u);
+}
+
+/**
+ * @brief Approximates quantiles from the running mean, variance, skewness 
+ * and kurtosis.
+ *
+ * This function evaluates the Cornish-Fisher expansion
+ * z + (z^2 - 1) g1 / 6 + (z^3 - 3 z) g2 / 24 - (2 z^3 - 5 z) g1^2 / 36,
+ * where z is the standard normal quantile, g1 the skewness and g2 the excess
+ * kurtosis. The expansion is accurate for distributions close to normal and 
+ * need not be monotonic in the probability for strongly skewed or heavy 
+ * tailed data.
+ * 
+ * @param results A pointer to an array of length m where the quantiles will 
+ * be stored.
+ * @param buffer A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`.
+ * @param probabilities A pointer to an array of m probabilities in (0, 1).
+ * @param m The number of quantiles.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_kurtosis_quantile_finalize(double *results, 
+double *buffer, const double *probabilities, size_t m) {
+    double moments[4];
+    double sigma;
+
+    incstats_kurtosis_finalize(moments, buffer);
+    sigma = sqrt(moments[1]);
+    for(size_t j = 0; j < m; j++) {
+        double z = incstats_normal_quantile(probabilities[j]);
+        double z2 = z * z;
+
+        results[j] = moments[0] + sigma * (z + (z2 - 1.0) * moments[2] / 6.0 +
+                     (z2 - 3.0) * z * (moments[3] - 3.0) / 24.0 - 
+                     (2.0 * z2 - 5.0) * z * moments[2] * moments[2] / 36.0);
+    }
+}
+
+/**
+ * @brief Approximates quantiles from kurtosis buffers stored one after 
+ * another.
+ *
+ * This function computes the same results as calling 
+ * `incstats_kurtosis_quantile_finalize` for every buffer. The normal 
+ * quantiles are computed once per probability, and the loop over the 
+ * buffers has no loop carried dependencies, so that the compiler can 
+ * vectorize it.
+ * 
+ * @param results A pointer to an array of length m * n. The quantiles of the
+ * i-th buffer are stored at `results[m * i]` to `results[m * i + m - 1]`.
+ * @param buffers A pointer to an array of length 5 * n holding n buffers 
+ * updated by `incstats_kurtosis`.
+ * @param n The number of buffers.
+ * @param probabilities A pointer to an array of m probabilities in (0, 1).
+ * @param m The number of quantiles.
+ * 
+ * @note Disjoint ranges of buffers may be finalized concurrently from 
+ * several threads. This call is non-destructive.
+ */
+inline void incstats_kurtosis_quantile_finalize_bulk(double *results, 
+const double *buffers, size_t n, const double *probabilities, size_t m) {
+    for(size_t j = 0; j < m; j++) {
+        double z = incstats_normal_quantile(probabilities[j]);
+        double h1 = (z * z - 1.0) / 6.0;
+        double h2 = (z * z - 3.0) * z / 24.0;
+        double h3 = -(2.0 * z * z - 5.0) * z / 36.0;
+
+        for(size_t i = 0; i < n; i++) {
+            const double *buffer = &buffers[5 * i];
+            double inverse_sum_w = 1.0 / buffer[0];
+            double variance = buffer[2] * inverse_sum_w;
+            double sigma = sqrt(variance);
+            double skewness = buffer[3] * inverse_sum_w / (variance * sigma);
+            double kurtosis = buffer[4] * inverse_sum_w / (variance * variance);
+
+            results[m * i + j] = buffer[1] + sigma * (z + h1 * skewness + 
+                                 h2 * (kurtosis - 3.0) + 
+                                 h3 * skewness * skewness);
+        }
+    }
+}
+
+/**
+ * @brief The highest order supported by 
+ * `incstats_central_moment_quantile_maxent`.
+ */
+#define INCSTATS_MAXENT_MAX_ORDER 16
+
+/**
+ * @brief The number of quadrature points used by 
+ * `incstats_central_moment_quantile_maxent`.
+ */
+#define INCSTATS_MAXENT_GRID 1024
+
+/**
+ * @brief Approximates quantiles from the running central moments with the
+ * maximum entropy density.
+ *
+ * This function finds the density on [lo, hi] with the largest entropy 
+ * among all densities with the central moments of `buffer` up to order p, 
+ * and inverts its distribution function. The data is mapped to [-1, 1], 
+ * where the density is exp(sum of l_j P_j(y)) with the Legendre polynomials 
+ * P_j, and the multipliers l_j are found with a damped Newton method on the 
+ * convex dual problem, evaluating the integrals with the midpoint rule on 
+ * INCSTATS_MAXENT_GRID points.
+ * 
+ * @param results A pointer to an array of length m where the quantiles will 
+ * be stored.
+ * @param buffer A pointer to a double array of length p + 1 used by 
+ * `incstats_central_moment`.
+ * @param p The order of the highest central moment to match, from 1 to 
+ * INCSTATS_MAXENT_MAX_ORDER.
+ * @param lo The lower bound of the support, e.g. the running minimum.
+ * @param hi The upper bound of the support, e.g. the running maximum.
+ * @param probabilities A pointer to an array of m probabilities in [0, 1].
+ * @param m The number of quantiles.
+ * @return true if the moments were matched, false if the arguments are 
+ * invalid or the solver did not converge. The quantiles of the last iterate
+ * are stored in both cases where the arguments are valid.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer. Moments close to the boundary of what a density on [lo, hi] can 
+ * have, e.g. of data concentrated on a few values, may fail to converge.
+ */
+bool incstats_central_moment_quantile_maxent(double *results, 
+                                             const double *buffer, uint64_t p,
+                                             double lo, double hi, 
+                                             const double *probabilities, 
+                                             size_t m);
+
+/**
+ * @brief Computes the population stability index between two histograms.
+ *
+ * The index is the sum over the bins of (p - q) * ln(p / q), where p and q 
+ * are the proportions of the bins in `counts` and `reference`. Both 
+ * histograms are smoothed by adding `epsilon` to every bin, so that empty 
+ * bins give a finite result. Common rules of thumb read values below 0.1 as
+ * stable and above 0.25 as a significant shift.
+ * 
+ * @param counts A pointer to an array of length `bins`, e.g. of today's data.
+ * @param reference A pointer to an array of length `bins`, e.g. of 
+ * yesterday's data.
+ * @param bins The number of bins of both histograms.
+ * @param epsilon The pseudo-count added to every bin, e.g. 0.5.
+ * @return The population stability index.
+ * 
+ * @note Both histograms must have the same binning. With an `epsilon` of 0 
+ * the histograms must not have empty bins.
+ */
+inline double incstats_histogram_psi(const uint64_t *counts, 
+const uint64_t *reference, size_t bins, double epsilon) {
+    double total = 0.0;
+    double total_reference = 0.0;
+    double psi = 0.0;
+
+    for(size_t i = 0; i < bins; i++) {
+        total += (double)counts[i];
+        total_reference += (double)reference[i];
+    }
+    total += epsilon * (double)bins;
+    total_reference += epsilon * (double)bins;
+    for(size_t i = 0; i < bins; i++) {
+        double p = ((double)counts[i] + epsilon) / total;
+        double q = ((double)reference[i] + epsilon) / total_reference;
+
+        psi += (p - q) * log(p / q);
+    }
+    return psi;
+}
+
+/**
+ * @brief Computes the Kullback-Leibler divergence between two histograms.
+ *
+ * The divergence is the sum over the bins of p * ln(p / q), where p and q 
+ * are the proportions of the bins in `counts` and `reference` after adding 
+ * `epsilon` to every bin. It is not symmetric, see `incstats_histogram_psi`
+ * for the symmetric sum of both directions.
+ * 
+ * @param counts A pointer to an array of length `bins`.
+ * @param reference A pointer to an array of length `bins`.
+ * @param bins The number of bins of both histograms.
+ * @param epsilon The pseudo-count added to every bin, e.g. 0.5.
+ * @return The divergence of `counts` from `reference` in nats.
+ * 
+ * @note Both histograms must have the same binning. With an `epsilon` of 0 
+ * the result is infinite if `reference` has an empty bin that is not empty
+ * in `counts`.
+ */
+inline double incstats_histogram_kl(const uint64_t *counts, 
+const uint64_t *reference, size_t bins, double epsilon) {
+    double total = 0.0;
+    double total_reference = 0.0;
+    double kl = 0.0;
+
+    for(size_t i = 0; i < bins; i++) {
+        total += (double)counts[i];
+        total_reference += (double)reference[i];
+    }
+    total += epsilon * (double)bins;
+    total_reference += epsilon * (double)bins;
+    for(size_t i = 0; i < bins; i++) {
+        double p = ((double)counts[i] + epsilon) / total;
+        double q = ((double)reference[i] + epsilon) / total_reference;
+
+        if(p > 0.0) {
+            kl += p * log(p / q);
+        }
+    }
+    return kl;
+}
+
+/**
+ * @brief Computes the Hellinger distance between two histograms.
+ *
+ * The distance is sqrt(1 - sum of sqrt(p * q)) over the proportions p and q
+ * of the bins. It is symmetric, bounded by 1 and well defined for empty 
+ * bins, so no smoothing is needed.
+ * 
+ * @param counts A pointer to an array of length `bins`.
+ * @param reference A pointer to an array of length `bins`.
+ * @param bins The number of bins of both histograms.
+ * @return The Hellinger distance in [0, 1].
+ * 
+ * @note Both histograms must have the same binning and must not be empty.
+ */
+inline double incstats_histogram_hellinger(const uint64_t *counts, 
+const uint64_t *reference, size_t bins) {
+    double total = 0.0;
+    double total_reference = 0.0;
+    double affinity = 0.0;
+
+    for(size_t i = 0; i < bins; i++) {
+        total += (double)counts[i];
+        total_reference += (double)reference[i];
+        affinity += sqrt((double)counts[i] * (double)reference[i]);
+    }
+    affinity /= sqrt(total * total_reference);
+    // Rounding may push the affinity of identical histograms above 1.
+    return affinity < 1.0 ? sqrt(1.0 - affinity) : 0.0;
+}
+
+/**
+ * @brief Approximates the Kullback-Leibler divergence between the datasets 
+ * of two kurtosis buffers.
+ *
+ * Both datasets are approximated by normal distributions with their running
+ * means and variances, for which the divergence has the closed form
+ * ln(s_q / s_p) + (s_p^2 + (m_p - m_q)^2) / (2 s_q^2) - 1 / 2.
+ * 
+ * @param buffer A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`, e.g. of today's data.
+ * @param reference A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`, e.g. of yesterday's data.
+ * @return The approximate divergence of `buffer` from `reference` in nats.
+ * 
+ * @note The skewness and kurtosis are not part of the approximation. Compare
+ * them directly, or use histograms, to detect changes of the shape.
+ */
+inline double incstats_kurtosis_kl(const double *buffer, 
+const double *reference) {
+    double variance = buffer[2] / buffer[0];
+    double variance_reference = reference[2] / reference[0];
+    double delta = buffer[1] - reference[1];
+
+    return 0.5 * (log(variance_reference / variance) + 
+           (variance + delta * delta) / variance_reference - 1.0);
+}
+
+/**
+ * @brief Approximates the Hellinger distance between the datasets of two 
+ * kurtosis buffers.
+ *
+ * Both datasets are approximated by normal distributions with their running
+ * means and variances, for which the squared distance has the closed form
+ * 1 - sqrt(2 s_p s_q / (s_p^2 + s_q^2)) exp(-(m_p - m_q)^2 / 
+ * (4 (s_p^2 + s_q^2))).
+ * 
+ * @param buffer A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`.
+ * @param reference A pointer to a double array of length 5 used by 
+ * `incstats_kurtosis`.
+ * @return The approximate Hellinger distance in [0, 1].
+ * 
+ * @note The skewness and kurtosis are not part of the approximation.
+ */
+inline double incstats_kurtosis_hellinger(const double *buffer, 
+const double *reference) {
+    double variance = buffer[2] / buffer[0];
+    double variance_reference = reference[2] / reference[0];
+    double sum = variance + variance_reference;
+    double delta = buffer[1] - reference[1];
+    double affinity = sqrt(2.0 * sqrt(variance * variance_reference) / sum) * 
+                      exp(-0.25 * delta * delta / sum);
+
+    return affinity < 1.0 ? sqrt(1.0 - affinity) : 0.0;
+}
+
+/**
+ * @brief Computes the Kolmogorov-Smirnov statistic and the 1-Wasserstein 
+ * distance between two histograms.
+ *
+ * Both distances compare the empirical distribution functions F and G of the
+ * histograms, which are accumulated in one walk over the bins: the 
+ * Kolmogorov-Smirnov statistic is the largest |F - G| and the 1-Wasserstein 
+ * (earth mover's) distance the area between F and G. As in 
+ * `incstats_histogram_central_moment_finalize`, the bin with index v 
+ * represents the value v, so the distance is measured in units of bins.
+ * 
+ * @param results A pointer to an array of length 2 where the results will 
+ * be stored:
+ *                - `results[0]` will store the Kolmogorov-Smirnov statistic.
+ *                - `results[1]` will store the 1-Wasserstein distance.
+ * @param counts A pointer to an array of length `bins`.
+ * @param reference A pointer to an array of length `bins`.
+ * @param bins The number of bins of both histograms.
+ * 
+ * @note Both histograms must have the same binning and must not be empty.
+ */
+inline void incstats_histogram_distance_finalize(double *results, 
+const uint64_t *counts, const uint64_t *reference, size_t bins) {
+    uint64_t total = 0;
+    uint64_t total_reference = 0;
+    uint64_t cumulative = 0;
+    uint64_t cumulative_reference = 0;
+    double ks = 0.0;
+    double wasserstein = 0.0;
+
+    for(size_t i = 0; i < bins; i++) {
+        total += counts[i];
+        total_reference += reference[i];
+    }
+    for(size_t i = 0; i < bins; i++) {
+        double delta;
+
+        // The integer sums keep F and G exact up to the final division.
+        cumulative += counts[i];
+        cumulative_reference += reference[i];
+        delta = fabs((double)cumulative / (double)total - 
+                     (double)cumulative_reference / (double)total_reference);
+        ks = delta > ks ? delta : ks;
+        wasserstein += delta;
+    }
+    results[0] = ks;
+    results[1] = wasserstein;
+}
+
+/**
+ * @brief Updates the running Allan variances of a series at octave spaced 
+ * averaging times.
+ *
+ * Level j receives the averages of consecutive, non-overlapping blocks of 
+ * 2^j values. Every block average is compared with the previous one on the
+ * same level, the difference is passed to `incstats_variance`, and pairs of
+ * block averages are averaged and passed on to level j + 1. Level j receives
+ * n / 2^j values, so an update costs O(1) amortized.
+ * 
+ * @param y The next value of the series, e.g. the fractional frequency or 
+ * the jitter averaged over the basic interval tau0.
+ * @param buffer A pointer to a double array of length 6 * levels. Level j
+ * is stored at `buffer[6 * j]` to `buffer[6 * j + 5]`:
+ *               - `buffer[6 * j]` holds the number of block averages 
+ *                 received.
+ *               - `buffer[6 * j + 1]` holds the block average waiting for 
+ *                 its pair.
+ *               - `buffer[6 * j + 2]` holds the previous block average.
+ *               - `buffer[6 * j + 3]` to `buffer[6 * j + 5]` hold the state
+ *                 of `incstats_variance` for the differences of consecutive
+ *                 block averages.
+ * @param levels The number of levels, i.e. averaging times tau0 to 
+ * 2^(levels - 1) tau0.
+ * 
+ * @note The results shall be finalized by incstats_allan_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_allan(double y, double *buffer, size_t levels) {
+    for(size_t j = 0; j < levels; j++) {
+        double *level = &buffer[6 * j];
+
+        if(level[0] > 0.0) {
+            incstats_variance(y - level[2], 1.0, &level[3]);
+        }
+        level[0] += 1.0;
+        level[2] = y;
+        if(fmod(level[0], 2.0) == 1.0) {
+            level[1] = y;
+            return;
+        }
+        y = 0.5 * (level[1] + y);
+    }
+}
+
+/**
+ * @brief Finalizes the running Allan variances.
+ *
+ * The Allan variance at averaging time 2^j tau0 is half the mean squared 
+ * difference of consecutive block averages of level j, computed from the 
+ * mean and variance of the differences. Its square root is the Allan 
+ * deviation.
+ * 
+ * @param results A pointer to an array of length 2 * levels where the 
+ * results will be stored:
+ *                - `results[2 * j]` will store the Allan variance at 
+ *                  averaging time 2^j tau0.
+ *                - `results[2 * j + 1]` will store the number of 
+ *                  differences it is based on, e.g. for confidence 
+ *                  intervals.
+ * @param buffer A pointer to a double array of length 6 * levels used by
+ * `incstats_allan`.
+ * @param levels The number of levels.
+ * 
+ * @note Levels without differences yield NAN. This call is non-destructive,
+ * allowing multiple calls to the same buffer.
+ */
+inline void incstats_allan_finalize(double *results, double *buffer, 
+size_t levels) {
+    for(size_t j = 0; j < levels; j++) {
+        const double *differences = &buffer[6 * j + 3];
+
+        results[2 * j] = 0.5 * (differences[2] / differences[0] + 
+                         differences[1] * differences[1]);
+        results[2 * j + 1] = differences[0];
+    }
+}
+
+/**
+ * @brief Computes the bin of a value in a range split into equal bins.
+ *
+ * @param x The value.
+ * @param lo The lower bound of the range.
+ * @param hi The upper bound of the range.
+ * @param bins The number of bins.
+ * @return The index of the bin containing `x`. Values outside of [lo, hi) 
+ * fall into the first or last bin.
+ */
+inline size_t incstats_bin_index(double x, double lo, double hi, size_t bins) {
+    double position = (x - lo) / (hi - lo) * (double)bins;
+
+    if(!(position >= 0.0)) {
+        return 0;
+    }
+    if(position >= (double)bins) {
+        return bins - 1;
+    }
+    return (size_t)position;
+}
+
+/**
+ * @brief Initializes a joint histogram of two streams.
+ *
+ * The joint histogram counts pairs (x, y) on a grid of bins * bins cells 
+ * over the fixed ranges [lo_x, hi_x) and [lo_y, hi_y). Its memory does not 
+ * grow with the data, and histograms with the same grid are merged by 
+ * adding their counts.
+ * 
+ * @param buffer A pointer to a double array of length 5 + bins * bins:
+ *               - `buffer[0]` holds the number of bins per axis.
+ *               - `buffer[1]` to `buffer[4]` hold lo_x, hi_x, lo_y and 
+ *                 hi_y.
+ *               - `buffer[5 + i * bins + j]` holds the sum of weights of 
+ *                 the pairs with x in bin i and y in bin j.
+ * @param bins The number of bins per axis.
+ * @param lo_x The lower bound of the range of x.
+ * @param hi_x The upper bound of the range of x.
+ * @param lo_y The lower bound of the range of y.
+ * @param hi_y The upper bound of the range of y.
+ */
+inline void incstats_joint_histogram_init(double *buffer, size_t bins, 
+double lo_x, double hi_x, double lo_y, double hi_y) {
+    buffer[0] = (double)bins;
+    buffer[1] = lo_x;
+    buffer[2] = hi_x;
+    buffer[3] = lo_y;
+    buffer[4] = hi_y;
+    memset(&buffer[5], 0, bins * bins * sizeof(double));
+}
+
+/**
+ * @brief Adds a pair of values to a joint histogram.
+ *
+ * @param x The new value of the first stream.
+ * @param y The new value of the second stream.
+ * @param w The weight of the pair.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * initialized by `incstats_joint_histogram_init`. Values outside of the 
+ * ranges are counted in the first or last bin of their axis.
+ */
+inline void incstats_joint_histogram(double x, double y, double w, 
+double *buffer) {
+    size_t bins = (size_t)buffer[0];
+    size_t i = incstats_bin_index(x, buffer[1], buffer[2], bins);
+    size_t j = incstats_bin_index(y, buffer[3], buffer[4], bins);
+
+    buffer[5 + i * bins + j] += w;
+}
+
+/**
+ * @brief Adds a batch of pairs of values to a joint histogram.
+ *
+ * @param x A pointer to an array of n values of the first stream.
+ * @param y A pointer to an array of n values of the second stream.
+ * @param w A pointer to an array of n weights.
+ * @param n The number of pairs.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * initialized by `incstats_joint_histogram_init`.
+ */
+inline void incstats_joint_histogram_batch(const double *x, const double *y,
+const double *w, size_t n, double *buffer) {
+    size_t bins = (size_t)buffer[0];
+    double *counts = &buffer[5];
+
+    for(size_t k = 0; k < n; k++) {
+        size_t i = incstats_bin_index(x[k], buffer[1], buffer[2], bins);
+        size_t j = incstats_bin_index(y[k], buffer[3], buffer[4], bins);
+
+        counts[i * bins + j] += w[k];
+    }
+}
+
+/**
+ * @brief Merges two joint histograms with the same grid.
+ *
+ * @param buffer A pointer to a double array of length 5 + bins * bins which
+ * the counts of `other` are added to.
+ * @param other A pointer to a double array of length 5 + bins * bins, e.g. 
+ * filled by another thread.
+ */
+inline void incstats_joint_histogram_merge(double *buffer, 
+const double *other) {
+    size_t cells = (size_t)buffer[0] * (size_t)buffer[0];
+
+    for(size_t k = 0; k < cells; k++) {
+        buffer[5 + k] += other[5 + k];
+    }
+}
+
+/**
+ * @brief Computes approximate rank correlations from a joint histogram.
+ *
+ * The values of a bin share its midrank, so the results are those of the 
+ * binned data, where all values of a bin are ties. Spearman's rho is the 
+ * Pearson correlation of the midranks, and Kendall's tau-b is computed from
+ * the concordant and discordant pairs of cells, which are counted with 
+ * running prefix sums over the rows in O(bins * bins).
+ * 
+ * @param results A pointer to an array of length 2 where the results will 
+ * be stored:
+ *                - `results[0]` will store Spearman's rho.
+ *                - `results[1]` will store Kendall's tau-b.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * updated by `incstats_joint_histogram`.
+ * @param scratch A pointer to a double array of length 3 * bins used as 
+ * scratch space for the marginal ranks and the prefix sums.
+ * 
+ * @note The results are NAN if all pairs share a bin of x or of y. This call
+ * is non-destructive, allowing multiple calls to the same buffer.
+ */
+void incstats_joint_histogram_correlation_finalize(double *results, 
+                                                   const double *buffer,
+                                                   double *scratch);
+
+/**
+ * @brief Computes a piecewise linear approximation of the binary logarithm.
+ *
+ * The bits of a positive double, read as an integer and scaled by 2^-52, 
+ * are its exponent plus 1023 plus the fraction of its mantissa. The result
+ * is exact at powers of two and linear in between, so equal bins of it are 
+ * log-linear: every octave is split into the same number of equal bins. It
+ * needs no call to log and vectorizes where the integer to double 
+ * conversion does.
+ * 
+ * @param x A positive, finite value.
+ * @return log2(x) rounded to the nearest power of two below `x` plus the 
+ * linear interpolation to the next one.
+ */
+inline double incstats_log_linear(double x) {
+    uint64_t bits;
+
+    memcpy(&bits, &x, sizeof(bits));
+    return (double)bits * (1.0 / 4503599627370496.0) - 1023.0;
+}
+
+/**
+ * @brief Adds a batch of pairs of positive values to a joint histogram with
+ * log-linear bins.
+ *
+ * The bins of the whole batch are computed in a first loop without 
+ * dependencies between the pairs, which the compiler can vectorize, and 
+ * counted in a second loop.
+ * 
+ * @param x A pointer to an array of n values of the first stream.
+ * @param y A pointer to an array of n values of the second stream.
+ * @param w A pointer to an array of n weights.
+ * @param n The number of pairs.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * initialized by `incstats_joint_histogram_init`, see 
+ * `incstats_joint_histogram_log`.
+ * @param cells A pointer to an array of length n used as scratch space for 
+ * the cell indices.
+ */
+inline void incstats_joint_histogram_log_batch(const double *x, 
+const double *y, const double *w, size_t n, double *buffer, size_t *cells) {
+    size_t bins = (size_t)buffer[0];
+    double lo_x = incstats_log_linear(buffer[1]);
+    double lo_y = incstats_log_linear(buffer[3]);
+    double scale_x = (double)bins / (incstats_log_linear(buffer[2]) - lo_x);
+    double scale_y = (double)bins / (incstats_log_linear(buffer[4]) - lo_y);
+    double last = (double)(bins - 1);
+
+    for(size_t k = 0; k < n; k++) {
+        double u = x[k] > buffer[1] ? (x[k] < buffer[2] ? x[k] : buffer[2]) : 
+                   buffer[1];
+        double v = y[k] > buffer[3] ? (y[k] < buffer[4] ? y[k] : buffer[4]) : 
+                   buffer[3];
+        double i = (incstats_log_linear(u) - lo_x) * scale_x;
+        double j = (incstats_log_linear(v) - lo_y) * scale_y;
+
+        i = i < last ? i : last;
+        j = j < last ? j : last;
+        cells[k] = (size_t)i * bins + (size_t)j;
+    }
+    for(size_t k = 0; k < n; k++) {
+        buffer[5 + cells[k]] += w[k];
+    }
+}
+
+/**
+ * @brief Adds a pair of positive values to a joint histogram with 
+ * log-linear bins.
+ *
+ * This function uses the grid of `incstats_joint_histogram_init`, but the 
+ * bins are equal in `incstats_log_linear` of the values instead of the 
+ * values themselves, which resolves heavy tailed data like latencies. The 
+ * ranges must be positive. Histograms filled with this function and with 
+ * `incstats_joint_histogram` must not be merged.
+ * 
+ * @param x The new value of the first stream.
+ * @param y The new value of the second stream.
+ * @param w The weight of the pair.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * initialized by `incstats_joint_histogram_init` with 0 < lo_x < hi_x and 
+ * 0 < lo_y < hi_y. Values outside of the ranges, including values that are
+ * not positive, are counted in the first or last bin of their axis.
+ */
+inline void incstats_joint_histogram_log(double x, double y, double w, 
+double *buffer) {
+    size_t cell;
+
+    incstats_joint_histogram_log_batch(&x, &y, &w, 1, buffer, &cell);
+}
+
+/**
+ * @brief Computes the entropies and the mutual information of the pairs 
+ * counted in a joint histogram.
+ *
+ * The entropies are those of the discrete distributions of the bins, so 
+ * they depend on the grid, while the mutual information 
+ * H(X) + H(Y) - H(X, Y) approaches the one of the continuous streams for 
+ * fine grids with enough data.
+ * 
+ * @param results A pointer to an array of length 4 where the results will 
+ * be stored in nats:
+ *                - `results[0]` will store the entropy H(X) of the bins of 
+ *                  x.
+ *                - `results[1]` will store the entropy H(Y) of the bins of 
+ *                  y.
+ *                - `results[2]` will store the joint entropy H(X, Y).
+ *                - `results[3]` will store the mutual information.
+ * @param buffer A pointer to a double array of length 5 + bins * bins 
+ * updated by `incstats_joint_histogram` or `incstats_joint_histogram_log`.
+ * 
+ * @note The histogram must not be empty. This call is non-destructive, 
+ * allowing multiple calls to the same buffer.
+ */
+inline void incstats_joint_histogram_entropy_finalize(double *results, 
+const double *buffer) {
+    size_t bins = (size_t)buffer[0];
+    const double *counts = &buffer[5];
+    double total = 0.0;
+    double sum_x = 0.0;
+    double sum_y = 0.0;
+    double sum_xy = 0.0;
+
+    // With c ln c summed over the counts, H = ln(total) - sum / total.
+    for(size_t i = 0; i < bins; i++) {
+        double row = 0.0;
+        double column = 0.0;
+
+        for(size_t j = 0; j < bins; j++) {
+            double count = counts[i * bins + j];
+
+            row += count;
+            column += counts[j * bins + i];
+            sum_xy += count > 0.0 ? count * log(count) : 0.0;
+        }
+        total += row;
+        sum_x += row > 0.0 ? row * log(row) : 0.0;
+        sum_y += column > 0.0 ? column * log(column) : 0.0;
+    }
+    results[0] = log(total) - sum_x / total;
+    results[1] = log(total) - sum_y / total;
+    results[2] = log(total) - sum_xy / total;
+    results[3] = results[0] + results[1] - results[2];
+}
+
+/**
+ * @brief Updates an additive Holt-Winters forecast of a series.
+ *
+ * This function applies the additive Holt-Winters (triple exponential 
+ * smoothing) recurrences for the level l, trend b and seasonal component s
+ * of the position of `x` in the season:
+ * l' = alpha (x - s) + (1 - alpha) (l + b),
+ * b' = beta (l' - l) + (1 - beta) b and
+ * s' = gamma (x - l') + (1 - gamma) s.
+ * The first value initializes the level, the trend and the seasonal 
+ * components start at 0.
+ * 
+ * @param x The next value of the series.
+ * @param buffer A pointer to a double array of length 3 + m:
+ *               - `buffer[0]` holds the number of values.
+ *               - `buffer[1]` holds the level.
+ *               - `buffer[2]` holds the trend.
+ *               - `buffer[3]` to `buffer[2 + m]` hold the seasonal 
+ *                 components.
+ * @param alpha The smoothing factor of the level in [0, 1].
+ * @param beta The smoothing factor of the trend in [0, 1].
+ * @param gamma The smoothing factor of the seasonal components in [0, 1].
+ * @param m The length of the season, 1 for a series without seasonality.
+ * 
+ * @note The results shall be finalized by incstats_holt_winters_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_holt_winters(double x, double *buffer, double alpha, 
+double beta, double gamma, size_t m) {
+    double *season = &buffer[3 + (size_t)fmod(buffer[0], (double)m)];
+    double level;
+
+    if(buffer[0] == 0.0) {
+        buffer[1] = x;
+    }
+    else {
+        level = alpha * (x - *season) + 
+                (1.0 - alpha) * (buffer[1] + buffer[2]);
+        buffer[2] = beta * (level - buffer[1]) + (1.0 - beta) * buffer[2];
+        buffer[1] = level;
+    }
+    *season = gamma * (x - buffer[1]) + (1.0 - gamma) * *season;
+    buffer[0] += 1.0;
+}
+
+/**
+ * @brief Updates the additive Holt-Winters forecasts of a bank of series 
+ * stored as a structure of arrays.
+ *
+ * This function applies `incstats_holt_winters` to the next value of every
+ * series. The series are updated in lockstep, so they share the position in 
+ * the season, and the loop over the series has no dependencies, which lets 
+ * the compiler vectorize it.
+ * 
+ * @param x A pointer to an array of the next values of the n series.
+ * @param buffers A pointer to 3 + m arrays of length n, where 
+ * `buffers[j][i]` holds the j-th entry of the buffer of the i-th series, see
+ * `incstats_holt_winters` for the layout.
+ * @param n The number of series.
+ * @param alpha The smoothing factor of the level in [0, 1].
+ * @param beta The smoothing factor of the trend in [0, 1].
+ * @param gamma The smoothing factor of the seasonal components in [0, 1].
+ * @param m The length of the season.
+ * 
+ * @note The arrays of `buffers` must not overlap each other or `x`.
+ */
+inline void incstats_holt_winters_soa(const double *x, double *const *buffers,
+size_t n, double alpha, double beta, double gamma, size_t m) {
+    double *count = buffers[0];
+    double *level = buffers[1];
+    double *trend = buffers[2];
+    double *season;
+
+    if(n == 0) {
+        return;
+    }
+    season = buffers[3 + (size_t)fmod(count[0], (double)m)];
+    if(count[0] == 0.0) {
+        for(size_t i = 0; i < n; i++) {
+            level[i] = x[i];
+        }
+    }
+    else {
+        for(size_t i = 0; i < n; i++) {
+            double new_level = alpha * (x[i] - season[i]) + 
+                               (1.0 - alpha) * (level[i] + trend[i]);
+
+            trend[i] = beta * (new_level - level[i]) + (1.0 - beta) * trend[i];
+            level[i] = new_level;
+        }
+    }
+    for(size_t i = 0; i < n; i++) {
+        season[i] = gamma * (x[i] - level[i]) + (1.0 - gamma) * season[i];
+        count[i] += 1.0;
+    }
+}
+
+/**
+ * @brief Finalizes an additive Holt-Winters forecast.
+ *
+ * @param results A pointer to an array of length `horizon` where the 
+ * forecasts l + h b + s of the next `horizon` values will be stored, 
+ * `results[h - 1]` holding the forecast h steps ahead.
+ * @param buffer A pointer to a double array of length 3 + m used by 
+ * `incstats_holt_winters`.
+ * @param m The length of the season.
+ * @param horizon The number of values to forecast.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_holt_winters_finalize(double *results, double *buffer,
+size_t m, size_t horizon) {
+    size_t position = (size_t)fmod(buffer[0], (double)m);
+
+    for(size_t h = 1; h <= horizon; h++) {
+        results[h - 1] = buffer[1] + (double)h * buffer[2] + 
+                         buffer[3 + (position + h - 1) % m];
+    }
+}
+
+/**
+ * @brief Updates a scalar Kalman filter of a noisy random walk.
+ *
+ * The filter tracks a state that changes by noise of variance `q` between 
+ * measurements, each measured with noise of variance `r`. The prediction 
+ * P + q of the variance is combined with the measurement `z` using the gain
+ * K = (P + q) / (P + q + r). The first measurement initializes the estimate
+ * with variance `r`.
+ * 
+ * @param z The next measurement.
+ * @param buffer A pointer to a double array of length 3:
+ *               - `buffer[0]` holds the number of measurements.
+ *               - `buffer[1]` holds the estimate of the state.
+ *               - `buffer[2]` holds the variance P of the estimate.
+ * @param q The variance of the process noise.
+ * @param r The variance of the measurement noise, must be positive.
+ * 
+ * @note The results shall be finalized by incstats_kalman_finalize.
+ * The `buffer` array is expected to be initialized to 0 before use.
+ */
+inline void incstats_kalman(double z, double *buffer, double q, double r) {
+    double prediction = buffer[0] > 0.0 ? buffer[2] + q : INFINITY;
+    double gain = buffer[0] > 0.0 ? prediction / (prediction + r) : 1.0;
+
+    buffer[1] = buffer[1] + gain * (z - buffer[1]);
+    buffer[2] = buffer[0] > 0.0 ? (1.0 - gain) * prediction : r;
+    buffer[0] += 1.0;
+}
+
+/**
+ * @brief Updates the scalar Kalman filters of a bank of series stored as a
+ * structure of arrays.
+ *
+ * This function applies `incstats_kalman` to the next measurement of every
+ * series. The loop over the series has no dependencies and selects instead
+ * of branching, which lets the compiler vectorize it.
+ * 
+ * @param z A pointer to an array of the next measurements of the n series.
+ * @param buffers A pointer to 3 arrays of length n, where `buffers[j][i]` 
+ * holds the j-th entry of the buffer of the i-th series, see 
+ * `incstats_kalman` for the layout.
+ * @param n The number of series.
+ * @param q The variance of the process noise.
+ * @param r The variance of the measurement noise, must be positive.
+ * 
+ * @note The arrays of `buffers` must not overlap each other or `z`.
+ */
+inline void incstats_kalman_soa(const double *z, double *const *buffers, 
+size_t n, double q, double r) {
+    double *count = buffers[0];
+    double *estimate = buffers[1];
+    double *variance = buffers[2];
+
+    for(size_t i = 0; i < n; i++) {
+        double prediction = count[i] > 0.0 ? variance[i] + q : INFINITY;
+        double gain = count[i] > 0.0 ? prediction / (prediction + r) : 1.0;
+
+        estimate[i] = estimate[i] + gain * (z[i] - estimate[i]);
+        variance[i] = count[i] > 0.0 ? (1.0 - gain) * prediction : r;
+        count[i] += 1.0;
+    }
+}
+
+/**
+ * @brief Finalizes a scalar Kalman filter.
+ *
+ * @param results A pointer to an array of length 2 where the results will 
+ * be stored:
+ *                - `results[0]` will store the estimate of the state, which 
+ *                  is also the forecast of the next measurement.
+ *                - `results[1]` will store the variance of the estimate.
+ * @param buffer A pointer to a double array of length 3 used by 
+ * `incstats_kalman`.
+ * 
+ * @note This call is non-destructive, allowing multiple calls to the same 
+ * buffer.
+ */
+inline void incstats_kalman_finalize(double *results, double *buffer) {
+    results[0] = buffer[1];
+    results[1] = buffer[2];
+}
+
 #endif
\ No newline at end of file
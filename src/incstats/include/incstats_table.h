@@ -0,0 +1,228 @@
+#ifndef INCSTATS_TABLE_H
+#define INCSTATS_TABLE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/**
+ * @brief Updates a buffer with a new value, e.g. `incstats_variance` or
+ * `incstats_kurtosis`.
+ */
+typedef void (*incstats_update_function)(double x, double w, double *buffer);
+
+/**
+ * @brief Merges the statistics of `other` into `buffer`, e.g.
+ * `incstats_variance_merge` or `incstats_kurtosis_merge`.
+ */
+typedef void (*incstats_merge_function)(double *buffer, const double *other);
+
+/**
+ * @brief A memory budget shared by several keyed accumulator tables.
+ *
+ * Every key held by a table charges `incstats_table_entry_bytes` of the
+ * table to `used`, and a table evicts its least recently updated keys before
+ * `used` would exceed `limit`. The accounting is one addition per inserted
+ * or evicted key. The budget is not thread safe; tables sharing it must be
+ * updated from one thread or under a common lock.
+ */
+typedef struct {
+    size_t limit;
+    size_t used;
+} incstats_budget;
+
+/**
+ * @brief A hash table of accumulator buffers keyed by 64 bit integers.
+ *
+ * The keys are found by open addressing with linear probing. The entries
+ * are stored densely, so `keys[i]` and the buffer at `states + i * length`
+ * for i < `count` enumerate the table, and they are linked in an intrusive
+ * list from the most recently updated entry `head` to the least recently
+ * updated entry `tail`. Evicted keys are merged into the buffer `other`.
+ * Keys that expire are spilled to an append-only file if one is set, and an
+ * index in memory maps them to the offsets of their records.
+ *
+ * @note The fields are read-only for users of the table. The table owns its
+ * memory, release it with incstats_table_free. Do not copy it.
+ */
+typedef struct {
+    size_t length;
+    incstats_update_function update;
+    incstats_merge_function merge;
+    incstats_budget *budget;
+    size_t count;
+    size_t capacity;
+    size_t mask;
+    size_t *slots;
+    uint64_t *keys;
+    size_t *previous;
+    size_t *next;
+    double *touched;
+    double *states;
+    size_t head;
+    size_t tail;
+    double *other;
+    uint64_t evictions;
+    double now;
+    FILE *spill;
+    double *record;
+    size_t spilled;
+    size_t spill_capacity;
+    size_t spill_mask;
+    size_t *spill_slots;
+    uint64_t *spill_keys;
+    uint64_t *spill_offsets;
+} incstats_table;
+
+/**
+ * @brief Marks the end of the list of entries and empty slots of an
+ * incstats_table.
+ */
+#define INCSTATS_TABLE_NONE SIZE_MAX
+
+/**
+ * @brief Initializes a keyed accumulator table.
+ *
+ * @param table A pointer to the table to initialize.
+ * @param length The number of doubles of the buffer of every key, e.g. 3 for
+ * `incstats_variance`.
+ * @param update The function applied to the buffer of a key by
+ * incstats_table_update.
+ * @param merge The function merging the buffer of an evicted key into the
+ * buffer `other`.
+ * @param budget A pointer to the budget charged for the keys of the table or
+ * NULL for a table without limit. The budget must outlive the table.
+ * @return true on success, false if the allocation failed.
+ */
+bool incstats_table_init(incstats_table *table, size_t length,
+                         incstats_update_function update,
+                         incstats_merge_function merge,
+                         incstats_budget *budget);
+
+/**
+ * @brief Computes the number of bytes charged to the budget per key.
+ *
+ * This is the memory of a key in the dense arrays and in the hash slots at
+ * the maximal load factor of one half. Geometric growth of the arrays may
+ * reserve up to twice as much.
+ *
+ * @param table A pointer to an initialized table.
+ * @return The number of bytes per key.
+ */
+size_t incstats_table_entry_bytes(const incstats_table *table);
+
+/**
+ * @brief Updates the buffer of a key with a new value.
+ *
+ * This function finds the key, inserting it with a zero initialized buffer
+ * if it is new, marks it as the most recently updated key at the time of
+ * incstats_table_set_time and applies the update function. A key that was
+ * spilled to the file of incstats_table_set_spill is reloaded and merged
+ * into the new buffer first. Inserting a key that would exceed the budget
+ * first evicts the least recently updated key of this table. If the table
+ * has no key to evict, the value is added to the buffer `other` instead.
+ *
+ * @param table A pointer to an initialized table.
+ * @param key The key.
+ * @param x The new value.
+ * @param w The weight of the new value `x`.
+ * @return A pointer to the updated buffer, which stays valid until the next
+ * call that inserts or evicts a key, or NULL if the allocation or the reload
+ * of a spilled key failed.
+ */
+double *incstats_table_update(incstats_table *table, uint64_t key, double x,
+                              double w);
+
+/**
+ * @brief Finds the buffer of a key without marking it as recently updated.
+ *
+ * @param table A pointer to an initialized table.
+ * @param key The key.
+ * @return A pointer to the buffer of the key, which stays valid until the
+ * next call that inserts or evicts a key, or NULL if the key is not in the
+ * table. Spilled keys are not in the table until they are updated again.
+ */
+double *incstats_table_find(const incstats_table *table, uint64_t key);
+
+/**
+ * @brief Merges the least recently updated key into the buffer `other` and
+ * removes it from the table.
+ *
+ * @param table A pointer to an initialized table.
+ * @return true if a key was evicted, false if the table is empty.
+ */
+bool incstats_table_evict(incstats_table *table);
+
+/**
+ * @brief Evicts the least recently updated keys until the budget is met,
+ * e.g. after its limit was lowered.
+ *
+ * @param table A pointer to an initialized table.
+ * @return The number of evicted keys.
+ */
+size_t incstats_table_enforce(incstats_table *table);
+
+/**
+ * @brief Sets the current time of a table.
+ *
+ * The time is recorded as the time of the last update of every key updated
+ * afterwards and compared against by incstats_table_expire. It is in any
+ * unit, e.g. seconds, and shall not decrease.
+ *
+ * @param table A pointer to an initialized table.
+ * @param now The current time.
+ */
+void incstats_table_set_time(incstats_table *table, double now);
+
+/**
+ * @brief Sets the file that expired keys are spilled to.
+ *
+ * The file is created or truncated and only appended to afterwards. Every
+ * record holds the key followed by its buffer in the native byte order. A
+ * key is spilled at most once at a time: reloading it removes it from the
+ * index, and expiring it again appends a new record.
+ *
+ * @param table A pointer to an initialized table.
+ * @param path The path of the file, or NULL to merge expired keys into the
+ * buffer `other` instead. The keys spilled to a previously set file are
+ * reloaded and merged into the buffer `other` before it is closed.
+ * @return true on success, false if the file could not be opened, the
+ * allocation failed or the keys of the previous file could not be reloaded.
+ * In the last case the previous file stays set, and the keys merged before
+ * the failed read are removed from its index, so a retry merges every key
+ * once.
+ */
+bool incstats_table_set_spill(incstats_table *table, const char *path);
+
+/**
+ * @brief Removes the keys that were not updated for longer than `ttl`.
+ *
+ * The keys are visited from the least recently updated one, so the cost is
+ * proportional to the number of expired keys. Expired keys are spilled to
+ * the file of incstats_table_set_spill, or merged into the buffer `other`
+ * without one, and return their bytes to the budget. The index of spilled
+ * keys is not charged to the budget.
+ *
+ * @param table A pointer to an initialized table.
+ * @param ttl The time to live after the last update.
+ * @return The number of expired keys, or SIZE_MAX if writing to the spill
+ * file failed. The key that failed stays in the table.
+ */
+size_t incstats_table_expire(incstats_table *table, double ttl);
+
+/**
+ * @brief Releases the memory of a table and returns its keys to the budget.
+ *
+ * The spill file is closed but not removed. The keys that are still spilled
+ * are dropped with the index, and the file alone cannot restore them since
+ * it also holds the stale records of reloaded keys. To keep their
+ * statistics, call incstats_table_set_spill with NULL first, which merges
+ * them into the buffer `other`, and read `other` before freeing the table.
+ *
+ * @param table A pointer to an initialized table.
+ */
+void incstats_table_free(incstats_table *table);
+
+#endif
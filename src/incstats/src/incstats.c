@@ -1,5 +1,155 @@
 #include "incstats.h"
 
+#if defined(__SSE__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define INCSTATS_HAVE_MXCSR
+// Flush-to-zero (bit 15) and denormals-are-zero (bit 6) of the MXCSR.
+#define INCSTATS_MXCSR_FTZ_DAZ 0x8040
+#endif
+
+
+// Rows 0 to INCSTATS_BINOMIAL_MAX_ORDER of Pascal's triangle, stored row after
+// row.
+const double incstats_binomials[] = {
+    1.0,
+    1.0, 1.0,
+    1.0, 2.0, 1.0,
+    1.0, 3.0, 3.0, 1.0,
+    1.0, 4.0, 6.0, 4.0, 1.0,
+    1.0, 5.0, 10.0, 10.0, 5.0, 1.0,
+    1.0, 6.0, 15.0, 20.0, 15.0, 6.0, 1.0,
+    1.0, 7.0, 21.0, 35.0, 35.0, 21.0, 7.0, 1.0,
+    1.0, 8.0, 28.0, 56.0, 70.0, 56.0, 28.0, 8.0, 1.0,
+    1.0, 9.0, 36.0, 84.0, 126.0, 126.0, 84.0, 36.0, 9.0, 1.0,
+    1.0, 10.0, 45.0, 120.0, 210.0, 252.0, 210.0, 120.0, 45.0, 10.0, 1.0,
+    1.0, 11.0, 55.0, 165.0, 330.0, 462.0, 462.0, 330.0, 165.0, 55.0, 11.0, 1.0,
+    1.0, 12.0, 66.0, 220.0, 495.0, 792.0, 924.0, 792.0, 495.0, 220.0, 66.0,
+    12.0, 1.0,
+    1.0, 13.0, 78.0, 286.0, 715.0, 1287.0, 1716.0, 1716.0, 1287.0, 715.0,
+    286.0, 78.0, 13.0, 1.0,
+    1.0, 14.0, 91.0, 364.0, 1001.0, 2002.0, 3003.0, 3432.0, 3003.0, 2002.0,
+    1001.0, 364.0, 91.0, 14.0, 1.0,
+    1.0, 15.0, 105.0, 455.0, 1365.0, 3003.0, 5005.0, 6435.0, 6435.0, 5005.0,
+    3003.0, 1365.0, 455.0, 105.0, 15.0, 1.0,
+    1.0, 16.0, 120.0, 560.0, 1820.0, 4368.0, 8008.0, 11440.0, 12870.0, 11440.0,
+    8008.0, 4368.0, 1820.0, 560.0, 120.0, 16.0, 1.0,
+    1.0, 17.0, 136.0, 680.0, 2380.0, 6188.0, 12376.0, 19448.0, 24310.0,
+    24310.0, 19448.0, 12376.0, 6188.0, 2380.0, 680.0, 136.0, 17.0, 1.0,
+    1.0, 18.0, 153.0, 816.0, 3060.0, 8568.0, 18564.0, 31824.0, 43758.0,
+    48620.0, 43758.0, 31824.0, 18564.0, 8568.0, 3060.0, 816.0, 153.0, 18.0,
+    1.0,
+    1.0, 19.0, 171.0, 969.0, 3876.0, 11628.0, 27132.0, 50388.0, 75582.0,
+    92378.0, 92378.0, 75582.0, 50388.0, 27132.0, 11628.0, 3876.0, 969.0, 171.0,
+    19.0, 1.0,
+    1.0, 20.0, 190.0, 1140.0, 4845.0, 15504.0, 38760.0, 77520.0, 125970.0,
+    167960.0, 184756.0, 167960.0, 125970.0, 77520.0, 38760.0, 15504.0, 4845.0,
+    1140.0, 190.0, 20.0, 1.0,
+    1.0, 21.0, 210.0, 1330.0, 5985.0, 20349.0, 54264.0, 116280.0, 203490.0,
+    293930.0, 352716.0, 352716.0, 293930.0, 203490.0, 116280.0, 54264.0,
+    20349.0, 5985.0, 1330.0, 210.0, 21.0, 1.0,
+    1.0, 22.0, 231.0, 1540.0, 7315.0, 26334.0, 74613.0, 170544.0, 319770.0,
+    497420.0, 646646.0, 705432.0, 646646.0, 497420.0, 319770.0, 170544.0,
+    74613.0, 26334.0, 7315.0, 1540.0, 231.0, 22.0, 1.0,
+    1.0, 23.0, 253.0, 1771.0, 8855.0, 33649.0, 100947.0, 245157.0, 490314.0,
+    817190.0, 1144066.0, 1352078.0, 1352078.0, 1144066.0, 817190.0, 490314.0,
+    245157.0, 100947.0, 33649.0, 8855.0, 1771.0, 253.0, 23.0, 1.0,
+    1.0, 24.0, 276.0, 2024.0, 10626.0, 42504.0, 134596.0, 346104.0, 735471.0,
+    1307504.0, 1961256.0, 2496144.0, 2704156.0, 2496144.0, 1961256.0,
+    1307504.0, 735471.0, 346104.0, 134596.0, 42504.0, 10626.0, 2024.0, 276.0,
+    24.0, 1.0,
+    1.0, 25.0, 300.0, 2300.0, 12650.0, 53130.0, 177100.0, 480700.0, 1081575.0,
+    2042975.0, 3268760.0, 4457400.0, 5200300.0, 5200300.0, 4457400.0,
+    3268760.0, 2042975.0, 1081575.0, 480700.0, 177100.0, 53130.0, 12650.0,
+    2300.0, 300.0, 25.0, 1.0,
+    1.0, 26.0, 325.0, 2600.0, 14950.0, 65780.0, 230230.0, 657800.0, 1562275.0,
+    3124550.0, 5311735.0, 7726160.0, 9657700.0, 10400600.0, 9657700.0,
+    7726160.0, 5311735.0, 3124550.0, 1562275.0, 657800.0, 230230.0, 65780.0,
+    14950.0, 2600.0, 325.0, 26.0, 1.0,
+    1.0, 27.0, 351.0, 2925.0, 17550.0, 80730.0, 296010.0, 888030.0, 2220075.0,
+    4686825.0, 8436285.0, 13037895.0, 17383860.0, 20058300.0, 20058300.0,
+    17383860.0, 13037895.0, 8436285.0, 4686825.0, 2220075.0, 888030.0,
+    296010.0, 80730.0, 17550.0, 2925.0, 351.0, 27.0, 1.0,
+    1.0, 28.0, 378.0, 3276.0, 20475.0, 98280.0, 376740.0, 1184040.0, 3108105.0,
+    6906900.0, 13123110.0, 21474180.0, 30421755.0, 37442160.0, 40116600.0,
+    37442160.0, 30421755.0, 21474180.0, 13123110.0, 6906900.0, 3108105.0,
+    1184040.0, 376740.0, 98280.0, 20475.0, 3276.0, 378.0, 28.0, 1.0,
+    1.0, 29.0, 406.0, 3654.0, 23751.0, 118755.0, 475020.0, 1560780.0,
+    4292145.0, 10015005.0, 20030010.0, 34597290.0, 51895935.0, 67863915.0,
+    77558760.0, 77558760.0, 67863915.0, 51895935.0, 34597290.0, 20030010.0,
+    10015005.0, 4292145.0, 1560780.0, 475020.0, 118755.0, 23751.0, 3654.0,
+    406.0, 29.0, 1.0,
+    1.0, 30.0, 435.0, 4060.0, 27405.0, 142506.0, 593775.0, 2035800.0,
+    5852925.0, 14307150.0, 30045015.0, 54627300.0, 86493225.0, 119759850.0,
+    145422675.0, 155117520.0, 145422675.0, 119759850.0, 86493225.0, 54627300.0,
+    30045015.0, 14307150.0, 5852925.0, 2035800.0, 593775.0, 142506.0, 27405.0,
+    4060.0, 435.0, 30.0, 1.0,
+    1.0, 31.0, 465.0, 4495.0, 31465.0, 169911.0, 736281.0, 2629575.0,
+    7888725.0, 20160075.0, 44352165.0, 84672315.0, 141120525.0, 206253075.0,
+    265182525.0, 300540195.0, 300540195.0, 265182525.0, 206253075.0,
+    141120525.0, 84672315.0, 44352165.0, 20160075.0, 7888725.0, 2629575.0,
+    736281.0, 169911.0, 31465.0, 4495.0, 465.0, 31.0, 1.0,
+    1.0, 32.0, 496.0, 4960.0, 35960.0, 201376.0, 906192.0, 3365856.0,
+    10518300.0, 28048800.0, 64512240.0, 129024480.0, 225792840.0, 347373600.0,
+    471435600.0, 565722720.0, 601080390.0, 565722720.0, 471435600.0,
+    347373600.0, 225792840.0, 129024480.0, 64512240.0, 28048800.0, 10518300.0,
+    3365856.0, 906192.0, 201376.0, 35960.0, 4960.0, 496.0, 32.0, 1.0,
+    1.0, 33.0, 528.0, 5456.0, 40920.0, 237336.0, 1107568.0, 4272048.0,
+    13884156.0, 38567100.0, 92561040.0, 193536720.0, 354817320.0, 573166440.0,
+    818809200.0, 1037158320.0, 1166803110.0, 1166803110.0, 1037158320.0,
+    818809200.0, 573166440.0, 354817320.0, 193536720.0, 92561040.0, 38567100.0,
+    13884156.0, 4272048.0, 1107568.0, 237336.0, 40920.0, 5456.0, 528.0, 33.0,
+    1.0,
+    1.0, 34.0, 561.0, 5984.0, 46376.0, 278256.0, 1344904.0, 5379616.0,
+    18156204.0, 52451256.0, 131128140.0, 286097760.0, 548354040.0, 927983760.0,
+    1391975640.0, 1855967520.0, 2203961430.0, 2333606220.0, 2203961430.0,
+    1855967520.0, 1391975640.0, 927983760.0, 548354040.0, 286097760.0,
+    131128140.0, 52451256.0, 18156204.0, 5379616.0, 1344904.0, 278256.0,
+    46376.0, 5984.0, 561.0, 34.0, 1.0,
+    1.0, 35.0, 595.0, 6545.0, 52360.0, 324632.0, 1623160.0, 6724520.0,
+    23535820.0, 70607460.0, 183579396.0, 417225900.0, 834451800.0,
+    1476337800.0, 2319959400.0, 3247943160.0, 4059928950.0, 4537567650.0,
+    4537567650.0, 4059928950.0, 3247943160.0, 2319959400.0, 1476337800.0,
+    834451800.0, 417225900.0, 183579396.0, 70607460.0, 23535820.0, 6724520.0,
+    1623160.0, 324632.0, 52360.0, 6545.0, 595.0, 35.0, 1.0,
+    1.0, 36.0, 630.0, 7140.0, 58905.0, 376992.0, 1947792.0, 8347680.0,
+    30260340.0, 94143280.0, 254186856.0, 600805296.0, 1251677700.0,
+    2310789600.0, 3796297200.0, 5567902560.0, 7307872110.0, 8597496600.0,
+    9075135300.0, 8597496600.0, 7307872110.0, 5567902560.0, 3796297200.0,
+    2310789600.0, 1251677700.0, 600805296.0, 254186856.0, 94143280.0,
+    30260340.0, 8347680.0, 1947792.0, 376992.0, 58905.0, 7140.0, 630.0, 36.0,
+    1.0,
+    1.0, 37.0, 666.0, 7770.0, 66045.0, 435897.0, 2324784.0, 10295472.0,
+    38608020.0, 124403620.0, 348330136.0, 854992152.0, 1852482996.0,
+    3562467300.0, 6107086800.0, 9364199760.0, 12875774670.0, 15905368710.0,
+    17672631900.0, 17672631900.0, 15905368710.0, 12875774670.0, 9364199760.0,
+    6107086800.0, 3562467300.0, 1852482996.0, 854992152.0, 348330136.0,
+    124403620.0, 38608020.0, 10295472.0, 2324784.0, 435897.0, 66045.0, 7770.0,
+    666.0, 37.0, 1.0,
+    1.0, 38.0, 703.0, 8436.0, 73815.0, 501942.0, 2760681.0, 12620256.0,
+    48903492.0, 163011640.0, 472733756.0, 1203322288.0, 2707475148.0,
+    5414950296.0, 9669554100.0, 15471286560.0, 22239974430.0, 28781143380.0,
+    33578000610.0, 35345263800.0, 33578000610.0, 28781143380.0, 22239974430.0,
+    15471286560.0, 9669554100.0, 5414950296.0, 2707475148.0, 1203322288.0,
+    472733756.0, 163011640.0, 48903492.0, 12620256.0, 2760681.0, 501942.0,
+    73815.0, 8436.0, 703.0, 38.0, 1.0,
+    1.0, 39.0, 741.0, 9139.0, 82251.0, 575757.0, 3262623.0, 15380937.0,
+    61523748.0, 211915132.0, 635745396.0, 1676056044.0, 3910797436.0,
+    8122425444.0, 15084504396.0, 25140840660.0, 37711260990.0, 51021117810.0,
+    62359143990.0, 68923264410.0, 68923264410.0, 62359143990.0, 51021117810.0,
+    37711260990.0, 25140840660.0, 15084504396.0, 8122425444.0, 3910797436.0,
+    1676056044.0, 635745396.0, 211915132.0, 61523748.0, 15380937.0, 3262623.0,
+    575757.0, 82251.0, 9139.0, 741.0, 39.0, 1.0,
+    1.0, 40.0, 780.0, 9880.0, 91390.0, 658008.0, 3838380.0, 18643560.0,
+    76904685.0, 273438880.0, 847660528.0, 2311801440.0, 5586853480.0,
+    12033222880.0, 23206929840.0, 40225345056.0, 62852101650.0, 88732378800.0,
+    113380261800.0, 131282408400.0, 137846528820.0, 131282408400.0,
+    113380261800.0, 88732378800.0, 62852101650.0, 40225345056.0, 23206929840.0,
+    12033222880.0, 5586853480.0, 2311801440.0, 847660528.0, 273438880.0,
+    76904685.0, 18643560.0, 3838380.0, 658008.0, 91390.0, 9880.0, 780.0, 40.0,
+    1.0
+};
+
 
 extern double incstats_pow(double x, uint64_t y);
 extern uint64_t factorial(uint64_t n);
@@ -17,4 +167,588 @@ extern void incstats_central_moment_finalize(double *results, double *buffer,
                                            uint64_t p, bool standardize);
 extern void incstats_max(double x, double *max);
 extern void incstats_min(double x, double *min);
-extern uint64_t n_choose_k(uint64_t n, uint64_t k);
\ No newline at end of file
+extern uint64_t n_choose_k(uint64_t n, uint64_t k);
+extern double incstats_binomial(uint64_t n, uint64_t k);
+extern void incstats_summary(double x, double w, double *buffer);
+extern void incstats_summary_finalize(double *results, double *buffer);
+extern bool incstats_moments_init(incstats_moments *moments, uint64_t p,
+                                  const incstats_allocator *allocator);
+extern double *incstats_moments_buffer(incstats_moments *moments);
+extern void incstats_moments_update(incstats_moments *moments, double x,
+                                    double w);
+extern void incstats_moments_finalize(double *results,
+                                      incstats_moments *moments,
+                                      bool standardize);
+extern void incstats_moments_move(incstats_moments *dst,
+                                  incstats_moments *src);
+extern void incstats_moments_free(incstats_moments *moments);
+extern void incstats_kurtosis_lazy(double x, double w, double *buffer);
+extern void incstats_kurtosis_lazy_finalize(double *results, double *buffer);
+extern void incstats_central_moment_lazy(double x, double w, double *buffer,
+                                         uint64_t p);
+extern void incstats_central_moment_lazy_finalize(double *results,
+                                                  double *buffer, uint64_t p,
+                                                  bool standardize);
+extern void incstats_kurtosis_finalize_bulk(double *results,
+                                            const double *buffers, size_t n);
+extern void incstats_kurtosis_finalize_soa(double *const *results,
+                                           const double *const *buffers,
+                                           size_t n);
+extern void incstats_histogram_u8(const uint8_t *x, size_t n,
+                                  uint64_t *counts);
+extern void incstats_histogram_u16(const uint16_t *x, size_t n,
+                                   uint64_t *counts);
+extern void incstats_histogram_merge(uint64_t *counts, const uint64_t *other,
+                                     size_t bins);
+extern void incstats_histogram_central_moment_finalize(double *results,
+                                                       const uint64_t *counts,
+                                                       size_t bins, uint64_t p,
+                                                       bool standardize);
+extern size_t incstats_rle_encode(double *values, double *counts,
+                                  const double *x, size_t n);
+extern void incstats_mean_rle(const double *values, const double *counts,
+                              size_t n, double *buffer);
+extern void incstats_variance_rle(const double *values, const double *counts,
+                                  size_t n, double *buffer);
+extern void incstats_skewness_rle(const double *values, const double *counts,
+                                  size_t n, double *buffer);
+extern void incstats_kurtosis_rle(const double *values, const double *counts,
+                                  size_t n, double *buffer);
+extern void incstats_central_moment_rle(const double *values,
+                                        const double *counts, size_t n,
+                                        double *buffer, uint64_t p);
+extern double incstats_log_add_exp(double a, double b);
+extern void incstats_variance_log(double x, double log_w, double *buffer);
+extern void incstats_variance_log_finalize(double *results, double *buffer);
+extern void incstats_kurtosis_log(double x, double log_w, double *buffer);
+extern void incstats_kurtosis_log_finalize(double *results, double *buffer);
+extern void incstats_variance_decay(double x, double w, double decay,
+                                   double *buffer);
+extern void incstats_fast_sincos(double x, double *sine, double *cosine);
+extern void incstats_circular(double theta, double w, double *buffer);
+extern void incstats_circular_merge(double *buffer, const double *other);
+extern void incstats_circular_batch(const double *theta, const double *w,
+                                    size_t n, double *buffer);
+extern void incstats_circular_finalize(double *results, double *buffer);
+extern double incstats_dot(const double *a, const double *b, size_t n);
+extern void incstats_axpy(double alpha, const double *x, double *y, size_t n);
+extern void incstats_scal(double alpha, double *x, size_t n);
+extern void incstats_mean_vector(const double *x, double w, double *buffer,
+                                 size_t d);
+extern void incstats_pca(const double *x, double w, double *buffer, size_t d,
+                         size_t k);
+extern void incstats_pca_batch(const double *x, const double *w, size_t n,
+                               double *buffer, size_t d, size_t k);
+extern void incstats_pca_finalize(double *results, double *buffer, size_t d,
+                                  size_t k);
+extern void incstats_mahalanobis(const double *x, double w, double *buffer,
+                                 size_t d);
+extern double incstats_mahalanobis_score(const double *x, double *buffer,
+                                         size_t d);
+extern void incstats_mahalanobis_finalize(double *results, double *buffer,
+                                          size_t d);
+extern size_t incstats_symmetric_index(const size_t *indices, size_t order);
+extern void incstats_comoment(const double *x, double w, double *buffer,
+                              size_t d);
+extern void incstats_comoment_merge(double *buffer, double *other, size_t d);
+extern void incstats_comoment_finalize(double *results, double *buffer,
+                                       size_t d, bool standardize);
+extern void incstats_variance_merge(double *buffer, const double *other);
+extern void incstats_kurtosis_merge(double *buffer, const double *other);
+extern void incstats_gmm(double x, double w, double *buffer, uint64_t k);
+extern void incstats_gmm_merge(double *buffer, const double *other,
+                               uint64_t k);
+extern void incstats_gmm_finalize(double *results, double *buffer,
+                                  uint64_t k);
+extern void incstats_kmeans_assign(size_t *labels, const double *x, size_t n,
+                                   const double *buffer, size_t d, size_t k);
+extern void incstats_kmeans_update(const double *x, const double *w,
+                                   const size_t *labels, size_t n,
+                                   double *buffer, size_t d, size_t k);
+extern void incstats_kmeans_batch(const double *x, const double *w,
+                                  size_t *labels, size_t n, double *buffer,
+                                  size_t d, size_t k);
+extern void incstats_kmeans_finalize(double *results, double *buffer,
+                                     size_t d, size_t k);
+extern double incstats_normal_quantile(double p);
+extern void incstats_kurtosis_quantile_finalize(double *results,
+                                                double *buffer,
+                                                const double *probabilities,
+                                                size_t m);
+extern void incstats_kurtosis_quantile_finalize_bulk(
+    double *results, const double *buffers, size_t n,
+    const double *probabilities, size_t m);
+extern double incstats_histogram_psi(const uint64_t *counts,
+                                     const uint64_t *reference, size_t bins,
+                                     double epsilon);
+extern double incstats_histogram_kl(const uint64_t *counts,
+                                    const uint64_t *reference, size_t bins,
+                                    double epsilon);
+extern double incstats_histogram_hellinger(const uint64_t *counts,
+                                           const uint64_t *reference,
+                                           size_t bins);
+extern double incstats_kurtosis_kl(const double *buffer,
+                                   const double *reference);
+extern double incstats_kurtosis_hellinger(const double *buffer,
+                                          const double *reference);
+extern void incstats_histogram_distance_finalize(double *results,
+                                                const uint64_t *counts,
+                                                const uint64_t *reference,
+                                                size_t bins);
+extern void incstats_allan(double y, double *buffer, size_t levels);
+extern void incstats_allan_finalize(double *results, double *buffer,
+                                    size_t levels);
+extern size_t incstats_bin_index(double x, double lo, double hi, size_t bins);
+extern void incstats_joint_histogram_init(double *buffer, size_t bins,
+                                          double lo_x, double hi_x,
+                                          double lo_y, double hi_y);
+extern void incstats_joint_histogram(double x, double y, double w,
+                                     double *buffer);
+extern void incstats_joint_histogram_batch(const double *x, const double *y,
+                                           const double *w, size_t n,
+                                           double *buffer);
+extern void incstats_joint_histogram_merge(double *buffer,
+                                           const double *other);
+extern double incstats_log_linear(double x);
+extern void incstats_joint_histogram_log(double x, double y, double w,
+                                         double *buffer);
+extern void incstats_joint_histogram_log_batch(const double *x,
+                                               const double *y,
+                                               const double *w, size_t n,
+                                               double *buffer, size_t *cells);
+extern void incstats_joint_histogram_entropy_finalize(double *results,
+                                                      const double *buffer);
+extern void incstats_holt_winters(double x, double *buffer, double alpha,
+                                  double beta, double gamma, size_t m);
+extern void incstats_holt_winters_soa(const double *x, double *const *buffers,
+                                      size_t n, double alpha, double beta,
+                                      double gamma, size_t m);
+extern void incstats_holt_winters_finalize(double *results, double *buffer,
+                                           size_t m, size_t horizon);
+extern void incstats_kalman(double z, double *buffer, double q, double r);
+extern void incstats_kalman_soa(const double *z, double *const *buffers,
+                                size_t n, double q, double r);
+extern void incstats_kalman_finalize(double *results, double *buffer);
+
+
+// The kernels copy the state and the powers of the mean shifts into local 
+// arrays of constant size. Once the order is a compile time constant, the 
+// loops are unrolled, the arrays live in registers and the binomial 
+// coefficients are folded into the instructions.
+#if defined(__clang__)
+#define INCSTATS_UNROLL _Pragma("clang loop unroll(full)")
+#elif defined(__GNUC__)
+#define INCSTATS_UNROLL _Pragma("GCC unroll 16")
+#else
+#define INCSTATS_UNROLL
+#endif
+
+static inline void central_moment_fixed(double x, double w, double *buffer,
+const uint64_t p) {
+    double moments[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+    double powers_old[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+    double powers_new[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+    double new_sum_w = buffer[0] + w;
+    double shift = (x - buffer[1]) / new_sum_w;
+    double delta_old = -w * shift;
+    double delta_new = buffer[0] * shift;
+
+    powers_old[0] = 1.0;
+    powers_new[0] = 1.0;
+    INCSTATS_UNROLL
+    for(uint64_t k = 1; k < p + 1; k++) {
+        moments[k] = buffer[k];
+        powers_old[k] = powers_old[k - 1] * delta_old;
+        powers_new[k] = powers_new[k - 1] * delta_new;
+    }
+    INCSTATS_UNROLL
+    for(uint64_t i = 2; i < p + 1; i++) {
+        const double *row = &incstats_binomials[i * (i + 1) / 2];
+        double tmp = 0.0;
+        INCSTATS_UNROLL
+        for(uint64_t k = 1; k < i - 1; k++) {
+            tmp += row[k] * moments[i - k] * powers_old[k];
+        }
+        buffer[i] = moments[i] + tmp + buffer[0] * powers_old[i] + 
+                    w * powers_new[i];
+    }
+    buffer[1] = buffer[1] + w * shift;
+    buffer[0] = new_sum_w;
+}
+
+#define INCSTATS_DEFINE_KERNELS(P)                                            \
+static void central_moment_kernel_##P(double x, double w, double *buffer) {   \
+    central_moment_fixed(x, w, buffer, P);                                    \
+}                                                                             \
+static void central_moment_kernel_unweighted_##P(double x, double w,          \
+double *buffer) {                                                             \
+    (void)w;                                                                  \
+    central_moment_fixed(x, 1.0, buffer, P);                                  \
+}
+
+INCSTATS_DEFINE_KERNELS(2)
+INCSTATS_DEFINE_KERNELS(3)
+INCSTATS_DEFINE_KERNELS(4)
+INCSTATS_DEFINE_KERNELS(5)
+INCSTATS_DEFINE_KERNELS(6)
+INCSTATS_DEFINE_KERNELS(7)
+INCSTATS_DEFINE_KERNELS(8)
+INCSTATS_DEFINE_KERNELS(9)
+INCSTATS_DEFINE_KERNELS(10)
+INCSTATS_DEFINE_KERNELS(11)
+INCSTATS_DEFINE_KERNELS(12)
+INCSTATS_DEFINE_KERNELS(13)
+INCSTATS_DEFINE_KERNELS(14)
+INCSTATS_DEFINE_KERNELS(15)
+INCSTATS_DEFINE_KERNELS(16)
+
+static const incstats_moment_kernel central_moment_kernels[] = {
+    central_moment_kernel_2, central_moment_kernel_3, 
+    central_moment_kernel_4, central_moment_kernel_5, 
+    central_moment_kernel_6, central_moment_kernel_7,
+    central_moment_kernel_8, central_moment_kernel_9, 
+    central_moment_kernel_10, central_moment_kernel_11, 
+    central_moment_kernel_12, central_moment_kernel_13,
+    central_moment_kernel_14, central_moment_kernel_15, 
+    central_moment_kernel_16
+};
+
+static const incstats_moment_kernel central_moment_kernels_unweighted[] = {
+    central_moment_kernel_unweighted_2, central_moment_kernel_unweighted_3,
+    central_moment_kernel_unweighted_4, central_moment_kernel_unweighted_5,
+    central_moment_kernel_unweighted_6, central_moment_kernel_unweighted_7,
+    central_moment_kernel_unweighted_8, central_moment_kernel_unweighted_9,
+    central_moment_kernel_unweighted_10, central_moment_kernel_unweighted_11,
+    central_moment_kernel_unweighted_12, central_moment_kernel_unweighted_13,
+    central_moment_kernel_unweighted_14, central_moment_kernel_unweighted_15,
+    central_moment_kernel_unweighted_16
+};
+
+incstats_moment_kernel incstats_central_moment_kernel(uint64_t p, 
+                                                      bool weighted) {
+    if(p < 2 || p > INCSTATS_KERNEL_MAX_ORDER) {
+        return NULL;
+    }
+    return weighted ? central_moment_kernels[p - 2] : 
+           central_moment_kernels_unweighted[p - 2];
+}
+
+void incstats_variance_decay_batch(const double *x, const double *w, size_t n,
+                                   double decay, double *buffer) {
+#ifdef INCSTATS_HAVE_MXCSR
+    unsigned int mxcsr = _mm_getcsr();
+    _mm_setcsr(mxcsr | INCSTATS_MXCSR_FTZ_DAZ);
+#endif
+    for(size_t i = 0; i < n; i++) {
+        incstats_variance_decay(x[i], w[i], decay, buffer);
+    }
+#ifdef INCSTATS_HAVE_MXCSR
+    _mm_setcsr(mxcsr);
+#endif
+}
+
+
+// Evaluates the Legendre polynomials P_0 to P_p at y.
+static void maxent_legendre(double y, uint64_t p, double *basis) {
+    basis[0] = 1.0;
+    basis[1] = y;
+    for(uint64_t j = 1; j < p; j++) {
+        basis[j + 1] = ((double)(2 * j + 1) * y * basis[j] - 
+                        (double)j * basis[j - 1]) / (double)(j + 1);
+    }
+}
+
+// Stores the exponent of the unnormalized density at every grid point and
+// returns the logarithm of its integral over [-1, 1].
+static double maxent_log_partition(const double *lambda, uint64_t p,
+                                   double *exponent) {
+    double h = 2.0 / INCSTATS_MAXENT_GRID;
+    double basis[INCSTATS_MAXENT_MAX_ORDER + 1];
+    double max = -INFINITY;
+    double sum = 0.0;
+
+    for(size_t g = 0; g < INCSTATS_MAXENT_GRID; g++) {
+        maxent_legendre(-1.0 + ((double)g + 0.5) * h, p, basis);
+        exponent[g] = 0.0;
+        for(uint64_t j = 1; j <= p; j++) {
+            exponent[g] += lambda[j] * basis[j];
+        }
+        max = exponent[g] > max ? exponent[g] : max;
+    }
+    for(size_t g = 0; g < INCSTATS_MAXENT_GRID; g++) {
+        sum += exp(exponent[g] - max);
+    }
+    return max + log(sum * h);
+}
+
+bool incstats_central_moment_quantile_maxent(double *results, 
+                                             const double *buffer, uint64_t p,
+                                             double lo, double hi, 
+                                             const double *probabilities, 
+                                             size_t m) {
+    double h = 2.0 / INCSTATS_MAXENT_GRID;
+    double coefficients[INCSTATS_MAXENT_MAX_ORDER + 1]
+                       [INCSTATS_MAXENT_MAX_ORDER + 1] = {{0.0}};
+    double raw[INCSTATS_MAXENT_MAX_ORDER + 1];
+    double target[INCSTATS_MAXENT_MAX_ORDER + 1] = {0.0};
+    double lambda[INCSTATS_MAXENT_MAX_ORDER + 1] = {0.0};
+    double trial[INCSTATS_MAXENT_MAX_ORDER + 1] = {0.0};
+    double gradient[INCSTATS_MAXENT_MAX_ORDER + 1];
+    double step[INCSTATS_MAXENT_MAX_ORDER + 1];
+    double hessian[INCSTATS_MAXENT_MAX_ORDER + 1]
+                  [INCSTATS_MAXENT_MAX_ORDER + 1];
+    double basis[INCSTATS_MAXENT_MAX_ORDER + 1];
+    double exponent[INCSTATS_MAXENT_GRID];
+    double scale;
+    double shift;
+    double log_z;
+    bool converged = false;
+
+    if(p < 1 || p > INCSTATS_MAXENT_MAX_ORDER || !(hi > lo) || 
+       !(buffer[0] > 0.0)) {
+        return false;
+    }
+    // Raw moments of y = scale * (x - mean) + shift, which maps [lo, hi] to
+    // [-1, 1].
+    scale = 2.0 / (hi - lo);
+    shift = (2.0 * buffer[1] - lo - hi) / (hi - lo);
+    for(uint64_t j = 0; j <= p; j++) {
+        double power = 1.0;
+
+        raw[j] = 0.0;
+        for(uint64_t i = 0; i <= j; i++) {
+            double central = i == 0 ? 1.0 : 
+                             i == 1 ? 0.0 : buffer[i] / buffer[0];
+
+            raw[j] += incstats_binomial(j, i) * power * central * 
+                      incstats_pow(shift, j - i);
+            power *= scale;
+        }
+    }
+    // Monomial coefficients of the Legendre polynomials give the targets.
+    coefficients[0][0] = 1.0;
+    coefficients[1][1] = 1.0;
+    for(uint64_t j = 1; j < p; j++) {
+        for(uint64_t i = 0; i <= j + 1; i++) {
+            double up = i > 0 ? coefficients[j][i - 1] : 0.0;
+
+            coefficients[j + 1][i] = ((double)(2 * j + 1) * up - 
+                                      (double)j * coefficients[j - 1][i]) / 
+                                     (double)(j + 1);
+        }
+    }
+    for(uint64_t j = 1; j <= p; j++) {
+        for(uint64_t i = 0; i <= j; i++) {
+            target[j] += coefficients[j][i] * raw[i];
+        }
+    }
+
+    for(size_t iteration = 0; iteration < 200; iteration++) {
+        double norm = 0.0;
+        double dual;
+        double decrease = 0.0;
+        double t = 1.0;
+        bool accepted = false;
+        bool singular = false;
+
+        log_z = maxent_log_partition(lambda, p, exponent);
+        memset(gradient, 0, sizeof(gradient));
+        memset(hessian, 0, sizeof(hessian));
+        for(size_t g = 0; g < INCSTATS_MAXENT_GRID; g++) {
+            double mass = exp(exponent[g] - log_z) * h;
+
+            maxent_legendre(-1.0 + ((double)g + 0.5) * h, p, basis);
+            for(uint64_t j = 1; j <= p; j++) {
+                gradient[j] += mass * basis[j];
+                for(uint64_t k = 1; k <= j; k++) {
+                    hessian[j][k] += mass * basis[j] * basis[k];
+                }
+            }
+        }
+        // The Hessian is the covariance of the Legendre polynomials.
+        for(uint64_t j = 1; j <= p; j++) {
+            for(uint64_t k = 1; k <= j; k++) {
+                hessian[j][k] -= gradient[j] * gradient[k];
+            }
+        }
+        for(uint64_t j = 1; j <= p; j++) {
+            gradient[j] -= target[j];
+            norm = fabs(gradient[j]) > norm ? fabs(gradient[j]) : norm;
+        }
+        if(norm < 1e-10) {
+            converged = true;
+            break;
+        }
+        // Cholesky factorization of the Hessian in its lower triangle.
+        for(uint64_t j = 1; j <= p && !singular; j++) {
+            for(uint64_t k = 1; k <= j; k++) {
+                double sum = hessian[j][k];
+
+                for(uint64_t i = 1; i < k; i++) {
+                    sum -= hessian[j][i] * hessian[k][i];
+                }
+                if(k < j) {
+                    hessian[j][k] = sum / hessian[k][k];
+                }
+                else if(sum > 0.0) {
+                    hessian[j][j] = sqrt(sum);
+                }
+                else {
+                    singular = true;
+                }
+            }
+        }
+        if(singular) {
+            break;
+        }
+        for(uint64_t j = 1; j <= p; j++) {
+            step[j] = gradient[j];
+            for(uint64_t i = 1; i < j; i++) {
+                step[j] -= hessian[j][i] * step[i];
+            }
+            step[j] /= hessian[j][j];
+        }
+        for(uint64_t j = p; j >= 1; j--) {
+            for(uint64_t i = j + 1; i <= p; i++) {
+                step[j] -= hessian[i][j] * step[i];
+            }
+            step[j] /= hessian[j][j];
+        }
+        // Backtracking line search on the dual log Z - lambda * target.
+        dual = log_z;
+        for(uint64_t j = 1; j <= p; j++) {
+            dual -= lambda[j] * target[j];
+            decrease += gradient[j] * step[j];
+        }
+        for(size_t halving = 0; halving < 40; halving++) {
+            double trial_dual;
+
+            for(uint64_t j = 1; j <= p; j++) {
+                trial[j] = lambda[j] - t * step[j];
+            }
+            trial_dual = maxent_log_partition(trial, p, exponent);
+            for(uint64_t j = 1; j <= p; j++) {
+                trial_dual -= trial[j] * target[j];
+            }
+            if(trial_dual <= dual - 1e-4 * t * decrease) {
+                accepted = true;
+                break;
+            }
+            t *= 0.5;
+        }
+        if(!accepted) {
+            break;
+        }
+        memcpy(lambda, trial, sizeof(lambda));
+    }
+
+    // Invert the distribution function, linear within each grid cell.
+    log_z = maxent_log_partition(lambda, p, exponent);
+    for(size_t g = 0; g < INCSTATS_MAXENT_GRID; g++) {
+        double mass = exp(exponent[g] - log_z) * h;
+
+        exponent[g] = g > 0 ? exponent[g - 1] + mass : mass;
+    }
+    for(size_t j = 0; j < m; j++) {
+        double total = exponent[INCSTATS_MAXENT_GRID - 1];
+        double probability = probabilities[j] * total;
+        size_t left = 0;
+        size_t right = INCSTATS_MAXENT_GRID - 1;
+        double before;
+        double y;
+
+        // Find the first cell whose cumulative mass reaches the probability.
+        while(left < right) {
+            size_t middle = left + (right - left) / 2;
+
+            if(exponent[middle] < probability) {
+                left = middle + 1;
+            }
+            else {
+                right = middle;
+            }
+        }
+        before = left > 0 ? exponent[left - 1] : 0.0;
+        y = -1.0 + h * ((double)left + (exponent[left] > before ? 
+            (probability - before) / (exponent[left] - before) : 0.5));
+        results[j] = lo + 0.5 * (y + 1.0) * (hi - lo);
+    }
+    return converged;
+}
+
+void incstats_joint_histogram_correlation_finalize(double *results, 
+                                                   const double *buffer,
+                                                   double *scratch) {
+    size_t bins = (size_t)buffer[0];
+    const double *counts = &buffer[5];
+    double *rows = scratch;
+    double *columns = &scratch[bins];
+    double *seen = &scratch[2 * bins];
+    double total = 0.0;
+    double cumulative;
+    double covariance = 0.0;
+    double variance_x = 0.0;
+    double variance_y = 0.0;
+    double ties_x = 0.0;
+    double ties_y = 0.0;
+    double concordant = 0.0;
+    double discordant = 0.0;
+
+    memset(scratch, 0, 3 * bins * sizeof(double));
+    for(size_t i = 0; i < bins; i++) {
+        for(size_t j = 0; j < bins; j++) {
+            rows[i] += counts[i * bins + j];
+            columns[j] += counts[i * bins + j];
+        }
+        total += rows[i];
+    }
+    // Replace the marginal counts by the centered midranks of their bins.
+    cumulative = 0.0;
+    for(size_t i = 0; i < bins; i++) {
+        double count = rows[i];
+
+        ties_x += count * count;
+        rows[i] = cumulative + 0.5 * count - 0.5 * total;
+        variance_x += count * rows[i] * rows[i];
+        cumulative += count;
+    }
+    cumulative = 0.0;
+    for(size_t j = 0; j < bins; j++) {
+        double count = columns[j];
+
+        ties_y += count * count;
+        columns[j] = cumulative + 0.5 * count - 0.5 * total;
+        variance_y += count * columns[j] * columns[j];
+        cumulative += count;
+    }
+    for(size_t i = 0; i < bins; i++) {
+        for(size_t j = 0; j < bins; j++) {
+            covariance += counts[i * bins + j] * rows[i] * columns[j];
+        }
+    }
+    // seen[j] holds the counts of the rows before the current row in column
+    // j. A cell is concordant with the cells seen in smaller columns and
+    // discordant with those seen in larger columns.
+    for(size_t i = 0; i < bins; i++) {
+        double seen_total = 0.0;
+        double smaller = 0.0;
+
+        for(size_t j = 0; j < bins; j++) {
+            seen_total += seen[j];
+        }
+        for(size_t j = 0; j < bins; j++) {
+            concordant += counts[i * bins + j] * smaller;
+            discordant += counts[i * bins + j] * 
+                          (seen_total - smaller - seen[j]);
+            smaller += seen[j];
+        }
+        for(size_t j = 0; j < bins; j++) {
+            seen[j] += counts[i * bins + j];
+        }
+    }
+    results[0] = covariance / sqrt(variance_x * variance_y);
+    // Pairs not tied in x are (total^2 - sum of row counts^2) / 2.
+    results[1] = (concordant - discordant) / 
+                 sqrt(0.25 * (total * total - ties_x) * 
+                      (total * total - ties_y));
+}
@@ -0,0 +1,472 @@
+#include "incstats_table.h"
+
+#include <string.h>
+
+
+#define INCSTATS_TABLE_INITIAL_CAPACITY 8
+
+// Finalizer of splitmix64, which spreads sequential keys over the slots.
+static size_t table_hash(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xbf58476d1ce4e5b9ULL;
+    key ^= key >> 27;
+    key *= 0x94d049bb133111ebULL;
+    key ^= key >> 31;
+    return (size_t)key;
+}
+
+// Returns the slot of `slots` holding the entry with `key` or the empty slot
+// where it belongs. The same probing serves the keys in memory and the index
+// of the spilled keys.
+static size_t map_slot(const size_t *slots, size_t mask, const uint64_t *keys,
+                       uint64_t key) {
+    size_t slot = table_hash(key) & mask;
+
+    while(slots[slot] != INCSTATS_TABLE_NONE && keys[slots[slot]] != key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static bool map_rehash(size_t **slots, size_t *mask, const uint64_t *keys,
+                       size_t count, size_t size) {
+    size_t *new_slots = (size_t *)malloc(size * sizeof(size_t));
+
+    if(new_slots == NULL) {
+        return false;
+    }
+    for(size_t i = 0; i < size; i++) {
+        new_slots[i] = INCSTATS_TABLE_NONE;
+    }
+    free(*slots);
+    *slots = new_slots;
+    *mask = size - 1;
+    for(size_t entry = 0; entry < count; entry++) {
+        new_slots[map_slot(new_slots, *mask, keys, keys[entry])] = entry;
+    }
+    return true;
+}
+
+// Empties a slot with backward shift deletion, which keeps the probe
+// sequences of the following keys unbroken.
+static void map_erase(size_t *slots, size_t mask, const uint64_t *keys,
+                      size_t slot) {
+    slots[slot] = INCSTATS_TABLE_NONE;
+    for(size_t next = (slot + 1) & mask; slots[next] != INCSTATS_TABLE_NONE;
+        next = (next + 1) & mask) {
+        size_t home = table_hash(keys[slots[next]]) & mask;
+
+        // Move the key back unless its home lies cyclically in (slot, next].
+        if(((next - home) & mask) >= ((next - slot) & mask)) {
+            slots[slot] = slots[next];
+            slots[next] = INCSTATS_TABLE_NONE;
+            slot = next;
+        }
+    }
+}
+
+static size_t table_slot(const incstats_table *table, uint64_t key) {
+    return map_slot(table->slots, table->mask, table->keys, key);
+}
+
+static bool table_rehash(incstats_table *table, size_t slots) {
+    return map_rehash(&table->slots, &table->mask, table->keys, table->count,
+                      slots);
+}
+
+static bool table_grow(incstats_table *table) {
+    size_t capacity = 2 * table->capacity;
+    uint64_t *keys;
+    size_t *previous;
+    size_t *next;
+    double *touched;
+    double *states;
+
+    // Arrays that were already grown stay valid if a later one fails.
+    keys = (uint64_t *)realloc(table->keys, capacity * sizeof(uint64_t));
+    if(keys == NULL) {
+        return false;
+    }
+    table->keys = keys;
+    previous = (size_t *)realloc(table->previous, capacity * sizeof(size_t));
+    if(previous == NULL) {
+        return false;
+    }
+    table->previous = previous;
+    next = (size_t *)realloc(table->next, capacity * sizeof(size_t));
+    if(next == NULL) {
+        return false;
+    }
+    table->next = next;
+    touched = (double *)realloc(table->touched, capacity * sizeof(double));
+    if(touched == NULL) {
+        return false;
+    }
+    table->touched = touched;
+    states = (double *)realloc(table->states,
+                               capacity * table->length * sizeof(double));
+    if(states == NULL) {
+        return false;
+    }
+    table->states = states;
+    table->capacity = capacity;
+    return true;
+}
+
+static void table_unlink(incstats_table *table, size_t entry) {
+    size_t previous = table->previous[entry];
+    size_t next = table->next[entry];
+
+    if(previous != INCSTATS_TABLE_NONE) {
+        table->next[previous] = next;
+    }
+    else {
+        table->head = next;
+    }
+    if(next != INCSTATS_TABLE_NONE) {
+        table->previous[next] = previous;
+    }
+    else {
+        table->tail = previous;
+    }
+}
+
+static void table_push_front(incstats_table *table, size_t entry) {
+    table->previous[entry] = INCSTATS_TABLE_NONE;
+    table->next[entry] = table->head;
+    if(table->head != INCSTATS_TABLE_NONE) {
+        table->previous[table->head] = entry;
+    }
+    else {
+        table->tail = entry;
+    }
+    table->head = entry;
+}
+
+// Removes an entry and moves the last entry into its place.
+static void table_remove(incstats_table *table, size_t entry) {
+    size_t slot = table_slot(table, table->keys[entry]);
+    size_t last = table->count - 1;
+
+    map_erase(table->slots, table->mask, table->keys, slot);
+    table_unlink(table, entry);
+    if(entry != last) {
+        table->keys[entry] = table->keys[last];
+        table->touched[entry] = table->touched[last];
+        memcpy(&table->states[entry * table->length],
+               &table->states[last * table->length],
+               table->length * sizeof(double));
+        table->previous[entry] = table->previous[last];
+        table->next[entry] = table->next[last];
+        if(table->previous[entry] != INCSTATS_TABLE_NONE) {
+            table->next[table->previous[entry]] = entry;
+        }
+        else {
+            table->head = entry;
+        }
+        if(table->next[entry] != INCSTATS_TABLE_NONE) {
+            table->previous[table->next[entry]] = entry;
+        }
+        else {
+            table->tail = entry;
+        }
+        table->slots[table_slot(table, table->keys[entry])] = entry;
+    }
+    table->count--;
+    if(table->budget != NULL) {
+        table->budget->used -= incstats_table_entry_bytes(table);
+    }
+}
+
+// Adds a key and the offset of its record to the index of spilled keys.
+static bool spill_insert(incstats_table *table, uint64_t key,
+                         uint64_t offset) {
+    if(table->spilled == table->spill_capacity) {
+        size_t capacity = table->spill_capacity > 0 ?
+                          2 * table->spill_capacity :
+                          INCSTATS_TABLE_INITIAL_CAPACITY;
+        uint64_t *keys = (uint64_t *)realloc(table->spill_keys,
+                                             capacity * sizeof(uint64_t));
+        uint64_t *offsets;
+
+        if(keys == NULL) {
+            return false;
+        }
+        table->spill_keys = keys;
+        offsets = (uint64_t *)realloc(table->spill_offsets,
+                                      capacity * sizeof(uint64_t));
+        if(offsets == NULL) {
+            return false;
+        }
+        table->spill_offsets = offsets;
+        table->spill_capacity = capacity;
+    }
+    if(2 * (table->spilled + 1) > table->spill_mask + 1 &&
+       !map_rehash(&table->spill_slots, &table->spill_mask, table->spill_keys,
+                   table->spilled, 2 * (table->spill_mask + 1))) {
+        return false;
+    }
+    table->spill_keys[table->spilled] = key;
+    table->spill_offsets[table->spilled] = offset;
+    table->spill_slots[map_slot(table->spill_slots, table->spill_mask,
+                                table->spill_keys, key)] = table->spilled;
+    table->spilled++;
+    return true;
+}
+
+// Removes the index entry in `slot` and moves the last entry into its place.
+static void spill_remove(incstats_table *table, size_t slot) {
+    size_t entry = table->spill_slots[slot];
+    size_t last = table->spilled - 1;
+
+    map_erase(table->spill_slots, table->spill_mask, table->spill_keys, slot);
+    if(entry != last) {
+        table->spill_keys[entry] = table->spill_keys[last];
+        table->spill_offsets[entry] = table->spill_offsets[last];
+        table->spill_slots[map_slot(table->spill_slots, table->spill_mask,
+                                    table->spill_keys,
+                                    table->spill_keys[entry])] = entry;
+    }
+    table->spilled--;
+}
+
+// Reads the buffer of the record at `offset` into `record`.
+static bool spill_read(incstats_table *table, uint64_t offset) {
+    return fseek(table->spill, (long)offset + (long)sizeof(uint64_t),
+                 SEEK_SET) == 0 &&
+           fread(table->record, sizeof(double), table->length,
+                 table->spill) == table->length;
+}
+
+// Merges the spilled keys into the buffer `other`, starting from the last
+// entry of the index. Every merged key leaves the index at once, so a read
+// that fails leaves no key both merged and spilled.
+static bool spill_drain(incstats_table *table) {
+    while(table->spilled > 0) {
+        size_t entry = table->spilled - 1;
+
+        if(!spill_read(table, table->spill_offsets[entry])) {
+            return false;
+        }
+        table->merge(table->other, table->record);
+        spill_remove(table, map_slot(table->spill_slots, table->spill_mask,
+                                     table->spill_keys,
+                                     table->spill_keys[entry]));
+    }
+    return true;
+}
+
+// Appends the record of an entry and returns its offset or UINT64_MAX.
+static uint64_t spill_write(incstats_table *table, size_t entry) {
+    long offset;
+
+    if(fseek(table->spill, 0, SEEK_END) != 0 ||
+       (offset = ftell(table->spill)) < 0 ||
+       fwrite(&table->keys[entry], sizeof(uint64_t), 1, table->spill) != 1 ||
+       fwrite(&table->states[entry * table->length], sizeof(double),
+              table->length, table->spill) != table->length) {
+        return UINT64_MAX;
+    }
+    return (uint64_t)offset;
+}
+
+bool incstats_table_init(incstats_table *table, size_t length,
+                         incstats_update_function update,
+                         incstats_merge_function merge,
+                         incstats_budget *budget) {
+    memset(table, 0, sizeof(*table));
+    table->length = length;
+    table->update = update;
+    table->merge = merge;
+    table->budget = budget;
+    table->head = INCSTATS_TABLE_NONE;
+    table->tail = INCSTATS_TABLE_NONE;
+    table->capacity = INCSTATS_TABLE_INITIAL_CAPACITY / 2;
+    table->other = (double *)calloc(length, sizeof(double));
+    if(table->other == NULL || !table_grow(table) ||
+       !table_rehash(table, 2 * INCSTATS_TABLE_INITIAL_CAPACITY) ||
+       !map_rehash(&table->spill_slots, &table->spill_mask, NULL, 0,
+                   2 * INCSTATS_TABLE_INITIAL_CAPACITY)) {
+        incstats_table_free(table);
+        return false;
+    }
+    return true;
+}
+
+size_t incstats_table_entry_bytes(const incstats_table *table) {
+    return sizeof(uint64_t) + 4 * sizeof(size_t) +
+           (table->length + 1) * sizeof(double);
+}
+
+double *incstats_table_update(incstats_table *table, uint64_t key, double x,
+                              double w) {
+    size_t slot = table_slot(table, key);
+    size_t entry = table->slots[slot];
+    double *state;
+
+    if(entry != INCSTATS_TABLE_NONE) {
+        if(entry != table->head) {
+            table_unlink(table, entry);
+            table_push_front(table, entry);
+        }
+        table->touched[entry] = table->now;
+        state = &table->states[entry * table->length];
+        table->update(x, w, state);
+        return state;
+    }
+    if(table->budget != NULL) {
+        size_t bytes = incstats_table_entry_bytes(table);
+
+        while(table->budget->used + bytes > table->budget->limit &&
+              incstats_table_evict(table)) {
+        }
+        if(table->budget->used + bytes > table->budget->limit) {
+            table->update(x, w, table->other);
+            return table->other;
+        }
+    }
+    if(table->count == table->capacity && !table_grow(table)) {
+        return NULL;
+    }
+    if(2 * (table->count + 1) > table->mask + 1) {
+        if(!table_rehash(table, 2 * (table->mask + 1))) {
+            return NULL;
+        }
+    }
+    state = &table->states[table->count * table->length];
+    memset(state, 0, table->length * sizeof(double));
+    if(table->spilled > 0) {
+        size_t spill_slot = map_slot(table->spill_slots, table->spill_mask,
+                                     table->spill_keys, key);
+        size_t spill_entry = table->spill_slots[spill_slot];
+
+        if(spill_entry != INCSTATS_TABLE_NONE) {
+            if(!spill_read(table, table->spill_offsets[spill_entry])) {
+                return NULL;
+            }
+            table->merge(state, table->record);
+            spill_remove(table, spill_slot);
+        }
+    }
+    // Evictions and rehashing may have moved the slot of the key.
+    slot = table_slot(table, key);
+    entry = table->count++;
+    table->keys[entry] = key;
+    table->touched[entry] = table->now;
+    table->slots[slot] = entry;
+    table_push_front(table, entry);
+    if(table->budget != NULL) {
+        table->budget->used += incstats_table_entry_bytes(table);
+    }
+    table->update(x, w, state);
+    return state;
+}
+
+double *incstats_table_find(const incstats_table *table, uint64_t key) {
+    size_t entry = table->slots[table_slot(table, key)];
+
+    if(entry == INCSTATS_TABLE_NONE) {
+        return NULL;
+    }
+    return &table->states[entry * table->length];
+}
+
+bool incstats_table_evict(incstats_table *table) {
+    size_t entry = table->tail;
+
+    if(entry == INCSTATS_TABLE_NONE) {
+        return false;
+    }
+    table->merge(table->other, &table->states[entry * table->length]);
+    table_remove(table, entry);
+    table->evictions++;
+    return true;
+}
+
+size_t incstats_table_enforce(incstats_table *table) {
+    size_t evicted = 0;
+
+    while(table->budget != NULL &&
+          table->budget->used > table->budget->limit &&
+          incstats_table_evict(table)) {
+        evicted++;
+    }
+    return evicted;
+}
+
+void incstats_table_set_time(incstats_table *table, double now) {
+    table->now = now;
+}
+
+bool incstats_table_set_spill(incstats_table *table, const char *path) {
+    FILE *spill = NULL;
+    double *record = table->record;
+
+    if(table->spill != NULL && !spill_drain(table)) {
+        return false;
+    }
+    if(path != NULL) {
+        if(record == NULL) {
+            record = (double *)malloc(table->length * sizeof(double));
+            if(record == NULL) {
+                return false;
+            }
+            table->record = record;
+        }
+        spill = fopen(path, "w+b");
+        if(spill == NULL) {
+            return false;
+        }
+    }
+    if(table->spill != NULL) {
+        fclose(table->spill);
+    }
+    table->spill = spill;
+    return true;
+}
+
+size_t incstats_table_expire(incstats_table *table, double ttl) {
+    size_t expired = 0;
+
+    while(table->tail != INCSTATS_TABLE_NONE &&
+          table->now - table->touched[table->tail] > ttl) {
+        size_t entry = table->tail;
+
+        if(table->spill != NULL) {
+            uint64_t offset = spill_write(table, entry);
+
+            if(offset == UINT64_MAX ||
+               !spill_insert(table, table->keys[entry], offset)) {
+                return SIZE_MAX;
+            }
+        }
+        else {
+            table->merge(table->other,
+                         &table->states[entry * table->length]);
+        }
+        table_remove(table, entry);
+        expired++;
+    }
+    return expired;
+}
+
+void incstats_table_free(incstats_table *table) {
+    if(table->budget != NULL) {
+        table->budget->used -= table->count * incstats_table_entry_bytes(table);
+    }
+    if(table->spill != NULL) {
+        fclose(table->spill);
+    }
+    free(table->slots);
+    free(table->keys);
+    free(table->previous);
+    free(table->next);
+    free(table->touched);
+    free(table->states);
+    free(table->other);
+    free(table->record);
+    free(table->spill_slots);
+    free(table->spill_keys);
+    free(table->spill_offsets);
+    memset(table, 0, sizeof(*table));
+}
@@ -1,9 +1,13 @@
 #include <stdio.h>
+#include <stdlib.h>
 
 #include <sys/time.h>
 
 #include "incstats.h"
 
+// Results of the benchmarks are stored here, so that their loops are kept.
+volatile double benchmark_sink;
+
 double time_elapsed(void (*function)()) {
     struct timeval tv_begin, tv_end;
     gettimeofday(&tv_begin, NULL);
@@ -33,6 +37,43 @@ void benchmark_incstats_variance() {
     }
 }
 
+void benchmark_incstats_variance_log() {
+    double buffer[4] = {0.0};
+    long long iterations = 1000000000;
+    volatile double input = 0;
+
+    for(long long i = 0; i < iterations; i++) {
+        incstats_variance_log(input++, 0.0, buffer);
+    }
+}
+
+void benchmark_incstats_variance_decay() {
+    double buffer[4] = {0.0};
+    long long iterations = 100000000;
+
+    // Tiny weights on a decaying state would produce subnormal 
+    // intermediates without rescaling.
+    for(long long i = 0; i < iterations; i++) {
+        incstats_variance_decay(1.0 + 1e-9 * (i % 7), 1e-300, 0.5, buffer);
+    }
+    benchmark_sink = buffer[1] + buffer[2];
+}
+
+void benchmark_incstats_variance_decay_naive() {
+    double buffer[3] = {0.0};
+    long long iterations = 100000000;
+
+    // The same decay applied to the state of incstats_variance, which keeps
+    // the sum of squares in the subnormal range. It runs about 10 times 
+    // slower, so both decay benchmarks use fewer iterations.
+    for(long long i = 0; i < iterations; i++) {
+        buffer[0] *= 0.5;
+        buffer[2] *= 0.5;
+        incstats_variance(1.0 + 1e-9 * (i % 7), 1e-300, buffer);
+    }
+    benchmark_sink = buffer[1] + buffer[2];
+}
+
 void benchmark_incstats_wskewness() {
     double buffer[4] = {0.0};
     long long iterations = 1000000000;
@@ -65,6 +106,34 @@ void benchmark_incstats_central_moment() {
     }
 }
 
+void benchmark_incstats_central_moment_kernel() {
+    long long iterations = 1000000000;
+    double buffer[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+    incstats_moment_kernel kernel = 
+    incstats_central_moment_kernel(INCSTATS_KERNEL_MAX_ORDER, true);
+    volatile double input = 0;
+
+    for(long long i = 0; i < iterations; i++) {
+        kernel(input++, 1, buffer);
+    }
+}
+
+void benchmark_incstats_kurtosis_finalize_bulk() {
+    size_t n = 1000000;
+    long long iterations = 100;
+    double *buffers = malloc(5 * n * sizeof(double));
+    double *results = malloc(4 * n * sizeof(double));
+
+    for(size_t i = 0; i < 5 * n; i++) {
+        buffers[i] = 1.0 + i % 5;
+    }
+    for(long long i = 0; i < iterations; i++) {
+        incstats_kurtosis_finalize_bulk(results, buffers, n);
+    }
+    free(buffers);
+    free(results);
+}
+
 int main(int argc, char const *argv[]) {
     double time = 0;
 
@@ -72,11 +141,21 @@ int main(int argc, char const *argv[]) {
     printf("Time incstats_mean(): %.16f sec\n", time);
     time = time_elapsed(benchmark_incstats_variance);
     printf("Time incstats_variance(): %.16f sec\n", time);
+    time = time_elapsed(benchmark_incstats_variance_log);
+    printf("Time incstats_variance_log(): %.16f sec\n", time);
+    time = time_elapsed(benchmark_incstats_variance_decay);
+    printf("Time incstats_variance_decay(): %.16f sec\n", time);
+    time = time_elapsed(benchmark_incstats_variance_decay_naive);
+    printf("Time incstats_variance() with decayed state: %.16f sec\n", time);
     time = time_elapsed(benchmark_incstats_wskewness);
     printf("Time incstats_wskewness(): %.16f sec\n", time);
     time = time_elapsed(benchmark_incstats_kurtosis);
     printf("Time incstats_wkurtosis(): %.16f sec\n", time);
     time = time_elapsed(benchmark_incstats_central_moment);
     printf("Time incstats_central_moment(): %.16f sec\n", time);
+    time = time_elapsed(benchmark_incstats_central_moment_kernel);
+    printf("Time incstats_central_moment_kernel(): %.16f sec\n", time);
+    time = time_elapsed(benchmark_incstats_kurtosis_finalize_bulk);
+    printf("Time incstats_kurtosis_finalize_bulk(): %.16f sec\n", time);
     return 0;
 }
\ No newline at end of file
@@ -7,8 +7,10 @@
 #include <math.h>
 #include <float.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "incstats.h"
+#include "incstats_table.h"
 
 #define LENGTH_ARRAY 1000
 #define ITERATIONS_TEST 100
@@ -20,6 +22,12 @@ void fill_random(double *array, size_t length, double min, double max) {
     }
 }
 
+double random_normal() {
+    double u = (rand() + 1.0) / ((double)RAND_MAX + 2.0);
+    double v = rand() / (double)RAND_MAX;
+    return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
 void test_incstats_mean() {
     for(size_t k = 0; k < ITERATIONS_TEST; k++) {
         double buffer[2] = {0.0};
@@ -243,6 +251,1565 @@ void test_incstats_min() {
     }
 }
 
+void test_incstats_summary() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double buffer[7] = {0.0};
+        double buffer_kurtosis[5] = {0.0};
+        double results[6] = {0.0};
+        double results_kurtosis[4] = {0.0};
+        double max = -DBL_MAX;
+        double min = DBL_MAX;
+
+        fill_random(x, LENGTH_ARRAY, -10.0, 10.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_summary(x[i], weights[i], buffer);
+            incstats_kurtosis(x[i], weights[i], buffer_kurtosis);
+            incstats_max(x[i], &max);
+            incstats_min(x[i], &min);
+        }
+        incstats_summary_finalize(results, buffer);
+        incstats_kurtosis_finalize(results_kurtosis, buffer_kurtosis);
+        for(size_t i = 0; i < 4; i++) {
+            assert(results[i] == results_kurtosis[i]);
+        }
+        assert(results[4] == max);
+        assert(results[5] == min);
+    }
+}
+
+void test_incstats_binomial() {
+    for(uint64_t n = 0; n <= INCSTATS_BINOMIAL_MAX_ORDER + 10; n++) {
+        for(uint64_t k = 0; k <= n; k++) {
+            assert(incstats_binomial(n, k) == (double)n_choose_k(n, k));
+        }
+    }
+    // Pascal's rule checks the rows beyond the table independently of 
+    // n_choose_k up to n = 56, whose coefficients are all below 2^53.
+    for(uint64_t n = 1; n <= 56; n++) {
+        assert(incstats_binomial(n, 0) == 1.0);
+        assert(incstats_binomial(n, n) == 1.0);
+        for(uint64_t k = 1; k < n; k++) {
+            assert(incstats_binomial(n, k) == incstats_binomial(n - 1, k - 1)
+                                              + incstats_binomial(n - 1, k));
+        }
+    }
+    assert(incstats_binomial(41, 20) == 269128937220.0);
+    assert(incstats_binomial(50, 25) == 126410606437752.0);
+    assert(incstats_binomial(56, 28) == 7648690600760440.0);
+}
+
+void test_central_moment_high_order() {
+    double x[LENGTH_ARRAY] = {0.0};
+    double weights[LENGTH_ARRAY] = {0.0};
+    uint64_t p = INCSTATS_BINOMIAL_MAX_ORDER + 4;
+    double buffer[INCSTATS_BINOMIAL_MAX_ORDER + 5] = {0.0};
+    double results[INCSTATS_BINOMIAL_MAX_ORDER + 6] = {0.0};
+    double sum_weights = 0.0;
+    double mass = 0.0;
+    double mean = 0.0;
+
+    fill_random(x, LENGTH_ARRAY, -1.0, 1.0);
+    fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+    for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+        incstats_central_moment(x[i], weights[i], buffer, p);
+        mass += weights[i] * x[i];
+        sum_weights += weights[i];
+    }
+    incstats_central_moment_finalize(results, buffer, p, false);
+    mean = mass / sum_weights;
+    for(uint64_t k = 2; k <= p; k++) {
+        double moment = 0.0;
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            moment += weights[i] * pow(x[i] - mean, k);
+        }
+        moment /= sum_weights;
+        assert(fabs(results[k] - moment) <= 1e-9 * fabs(moment) + 1e-14);
+    }
+}
+
+typedef struct {
+    size_t allocations;
+    size_t deallocations;
+} counting_allocator_state;
+
+void *counting_allocate(size_t size, void *context) {
+    ((counting_allocator_state *)context)->allocations++;
+    return malloc(size);
+}
+
+void counting_deallocate(void *ptr, void *context) {
+    ((counting_allocator_state *)context)->deallocations++;
+    free(ptr);
+}
+
+void test_incstats_moments() {
+    counting_allocator_state state = {0, 0};
+    incstats_allocator allocator = {counting_allocate, counting_deallocate,
+                                    &state};
+    uint64_t orders[3] = {4, INCSTATS_MOMENTS_INLINE_ORDER, 12};
+
+    for(size_t m = 0; m < 3; m++) {
+        uint64_t p = orders[m];
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double buffer[12 + 1] = {0.0};
+        double results[12 + 2] = {0.0};
+        double results_cmp[12 + 2] = {0.0};
+        incstats_moments moments;
+        incstats_moments moved;
+
+        assert(incstats_moments_init(&moments, p, &allocator));
+        assert(state.allocations == (p > INCSTATS_MOMENTS_INLINE_ORDER));
+        fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_moments_update(&moments, x[i], weights[i]);
+            incstats_central_moment(x[i], weights[i], buffer, p);
+        }
+        incstats_moments_move(&moved, &moments);
+        incstats_moments_free(&moments);
+        assert(state.deallocations == 0);
+        incstats_moments_finalize(results, &moved, true);
+        incstats_central_moment_finalize(results_cmp, buffer, p, true);
+        for(size_t i = 0; i < p + 2; i++) {
+            assert(results[i] == results_cmp[i]);
+        }
+        incstats_moments_free(&moved);
+        assert(state.deallocations == state.allocations);
+        state.allocations = 0;
+        state.deallocations = 0;
+    }
+}
+
+void test_central_moment_kernel() {
+    double x[LENGTH_ARRAY] = {0.0};
+    double weights[LENGTH_ARRAY] = {0.0};
+
+    assert(incstats_central_moment_kernel(1, true) == NULL);
+    assert(incstats_central_moment_kernel(INCSTATS_KERNEL_MAX_ORDER + 1, 
+           false) == NULL);
+    fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+    fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+    for(uint64_t p = 2; p <= INCSTATS_KERNEL_MAX_ORDER; p++) {
+        incstats_moment_kernel weighted = incstats_central_moment_kernel(p, 
+                                          true);
+        incstats_moment_kernel unweighted = incstats_central_moment_kernel(p,
+                                            false);
+        double buffer[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+        double buffer_weighted[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+        double buffer_unweighted[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+        double buffer_unit[INCSTATS_KERNEL_MAX_ORDER + 1] = {0.0};
+
+        assert(weighted != NULL && unweighted != NULL);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_central_moment(x[i], weights[i], buffer, p);
+            weighted(x[i], weights[i], buffer_weighted);
+            incstats_central_moment(x[i], 1.0, buffer_unit, p);
+            unweighted(x[i], weights[i], buffer_unweighted);
+        }
+        for(uint64_t i = 0; i < p + 1; i++) {
+            assert(fabs(buffer[i] - buffer_weighted[i]) <= 
+                   1e-12 * fabs(buffer[i]));
+            assert(fabs(buffer_unit[i] - buffer_unweighted[i]) <= 
+                   1e-12 * fabs(buffer_unit[i]));
+        }
+    }
+}
+
+void test_incstats_lazy() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        uint64_t p = 6;
+        double buffer_kurtosis[5] = {0.0};
+        double buffer_kurtosis_lazy[10] = {0.0};
+        double buffer_moment[6 + 1] = {0.0};
+        double buffer_moment_lazy[2 * 6 + 4] = {0.0};
+        double results[6 + 2] = {0.0};
+        double results_lazy[6 + 2] = {0.0};
+
+        fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_kurtosis(x[i], weights[i], buffer_kurtosis);
+            incstats_kurtosis_lazy(x[i], weights[i], buffer_kurtosis_lazy);
+            incstats_central_moment(x[i], weights[i], buffer_moment, p);
+            incstats_central_moment_lazy(x[i], weights[i], buffer_moment_lazy,
+                                         p);
+            if(i % 10 != 0) {
+                continue;
+            }
+            // Finalize twice to go through the cached path.
+            for(size_t j = 0; j < 2; j++) {
+                incstats_kurtosis_finalize(results, buffer_kurtosis);
+                incstats_kurtosis_lazy_finalize(results_lazy, 
+                                                buffer_kurtosis_lazy);
+                assert(memcmp(results, results_lazy, 4 * sizeof(double)) 
+                       == 0);
+                assert(buffer_kurtosis_lazy[5] != 0.0);
+            }
+            for(size_t j = 0; j < 4; j++) {
+                bool standardize = j > 1;
+                incstats_central_moment_finalize(results, buffer_moment, p, 
+                                                 standardize);
+                incstats_central_moment_lazy_finalize(results_lazy,
+                                                      buffer_moment_lazy, p,
+                                                      standardize);
+                assert(memcmp(results, results_lazy, (p + 2) * sizeof(double))
+                       == 0);
+            }
+        }
+        assert(memcmp(buffer_kurtosis, buffer_kurtosis_lazy, 
+               5 * sizeof(double)) == 0);
+        assert(memcmp(buffer_moment, buffer_moment_lazy, 
+               (p + 1) * sizeof(double)) == 0);
+    }
+}
+
+void test_incstats_kurtosis_finalize_bulk() {
+    size_t n = 100;
+    double x[LENGTH_ARRAY] = {0.0};
+    double weights[LENGTH_ARRAY] = {0.0};
+    double buffers[5 * 100] = {0.0};
+    double soa[5][100] = {{0.0}};
+    double results[4 * 100] = {0.0};
+    double results_soa[4][100] = {{0.0}};
+    const double *soa_buffers[5] = {soa[0], soa[1], soa[2], soa[3], soa[4]};
+    double *soa_results[4] = {results_soa[0], results_soa[1], results_soa[2],
+                              results_soa[3]};
+
+    for(size_t i = 0; i < n; i++) {
+        fill_random(x, LENGTH_ARRAY / 10, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY / 10, 1e-5, 1.0);
+        for(size_t j = 0; j < LENGTH_ARRAY / 10; j++) {
+            incstats_kurtosis(x[j], weights[j], &buffers[5 * i]);
+        }
+        for(size_t j = 0; j < 5; j++) {
+            soa[j][i] = buffers[5 * i + j];
+        }
+    }
+    incstats_kurtosis_finalize_bulk(results, buffers, n);
+    incstats_kurtosis_finalize_soa(soa_results, soa_buffers, n);
+    for(size_t i = 0; i < n; i++) {
+        double cmp[4] = {0.0};
+        incstats_kurtosis_finalize(cmp, &buffers[5 * i]);
+        for(size_t j = 0; j < 4; j++) {
+            assert(fabs(results[4 * i + j] - cmp[j]) <= 1e-12 * fabs(cmp[j]));
+            assert(results_soa[j][i] == results[4 * i + j]);
+        }
+    }
+}
+
+void test_incstats_histogram() {
+    uint64_t p = 8;
+    uint8_t x8[LENGTH_ARRAY] = {0};
+    uint16_t x16[LENGTH_ARRAY] = {0};
+    uint64_t *counts8 = calloc(256, sizeof(uint64_t));
+    uint64_t *counts8_other = calloc(256, sizeof(uint64_t));
+    uint64_t *counts16 = calloc(65536, sizeof(uint64_t));
+    double buffer8[8 + 1] = {0.0};
+    double buffer16[8 + 1] = {0.0};
+    double results[8 + 2] = {0.0};
+    double results_cmp[8 + 2] = {0.0};
+
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            // Sensor like data concentrated around the middle of the range.
+            x8[i] = (uint8_t)(96 + rand() % 32 + rand() % 32 + 
+                              (k % 2) * (rand() % 64));
+            x16[i] = (uint16_t)(rand() % 65536);
+            incstats_central_moment(x8[i], 1.0, buffer8, p);
+            incstats_central_moment(x16[i], 1.0, buffer16, p);
+        }
+        // Odd lengths exercise the remainder loop and short inputs the 
+        // direct count.
+        incstats_histogram_u8(x8, LENGTH_ARRAY - k % 4, 
+                              k % 2 ? counts8_other : counts8);
+        incstats_histogram_u8(&x8[LENGTH_ARRAY - k % 4], k % 4, counts8);
+        incstats_histogram_u16(x16, LENGTH_ARRAY, counts16);
+    }
+    incstats_histogram_merge(counts8, counts8_other, 256);
+    for(size_t j = 0; j < 2; j++) {
+        incstats_histogram_central_moment_finalize(results, counts8, 256, p,
+                                                   j == 1);
+        incstats_central_moment_finalize(results_cmp, buffer8, p, j == 1);
+        for(size_t i = 0; i < p + 2; i++) {
+            assert(fabs(results[i] - results_cmp[i]) <= 
+                   1e-9 * fabs(results_cmp[i]) + 1e-9);
+        }
+        incstats_histogram_central_moment_finalize(results, counts16, 65536,
+                                                   p, j == 1);
+        incstats_central_moment_finalize(results_cmp, buffer16, p, j == 1);
+        for(size_t i = 0; i < p + 2; i++) {
+            assert(fabs(results[i] - results_cmp[i]) <= 
+                   1e-9 * fabs(results_cmp[i]) + 1e-9);
+        }
+    }
+    free(counts8);
+    free(counts8_other);
+    free(counts16);
+}
+
+void test_incstats_rle() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double values[LENGTH_ARRAY] = {0.0};
+        double counts[LENGTH_ARRAY] = {0.0};
+        double buffers[5][8] = {{0.0}};
+        double buffers_rle[5][8] = {{0.0}};
+        uint64_t p = 6;
+        size_t runs = 0;
+        size_t sum_counts = 0;
+
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            x[i] = i > 0 && rand() % 8 != 0 ? x[i - 1] : 
+                   rand() / (double)RAND_MAX;
+            incstats_mean(x[i], 1.0, buffers[0]);
+            incstats_variance(x[i], 1.0, buffers[1]);
+            incstats_skewness(x[i], 1.0, buffers[2]);
+            incstats_kurtosis(x[i], 1.0, buffers[3]);
+            incstats_central_moment(x[i], 1.0, buffers[4], p);
+        }
+        runs = incstats_rle_encode(values, counts, x, LENGTH_ARRAY);
+        assert(runs < LENGTH_ARRAY / 2);
+        for(size_t i = 0; i < runs; i++) {
+            assert(i == 0 || values[i] != values[i - 1]);
+            sum_counts += (size_t)counts[i];
+        }
+        assert(sum_counts == LENGTH_ARRAY);
+        incstats_mean_rle(values, counts, runs, buffers_rle[0]);
+        incstats_variance_rle(values, counts, runs, buffers_rle[1]);
+        incstats_skewness_rle(values, counts, runs, buffers_rle[2]);
+        incstats_kurtosis_rle(values, counts, runs, buffers_rle[3]);
+        incstats_central_moment_rle(values, counts, runs, buffers_rle[4], p);
+        for(size_t i = 0; i < 5; i++) {
+            for(size_t j = 0; j < 8; j++) {
+                assert(fabs(buffers[i][j] - buffers_rle[i][j]) <= 
+                       1e-9 * fabs(buffers[i][j]) + 1e-12);
+            }
+        }
+    }
+}
+
+void test_incstats_log_weights() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double log_weights[LENGTH_ARRAY] = {0.0};
+        double buffer_variance[3] = {0.0};
+        double buffer_kurtosis[5] = {0.0};
+        double buffer_variance_log[4] = {0.0};
+        double buffer_kurtosis_log[6] = {0.0};
+        double results[4] = {0.0};
+        double results_log[4] = {0.0};
+        double max_log_w = -DBL_MAX;
+        double sum_w = 0.0;
+        double mean = 0.0;
+        double moments[5] = {0.0};
+
+        fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        // Moderate weights must give the results of the linear path.
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_variance(x[i], weights[i], buffer_variance);
+            incstats_kurtosis(x[i], weights[i], buffer_kurtosis);
+            incstats_variance_log(x[i], log(weights[i]), buffer_variance_log);
+            incstats_kurtosis_log(x[i], log(weights[i]), buffer_kurtosis_log);
+        }
+        incstats_variance_finalize(results, buffer_variance);
+        incstats_variance_log_finalize(results_log, buffer_variance_log);
+        for(size_t i = 0; i < 2; i++) {
+            assert(fabs(results[i] - results_log[i]) < 1e-10);
+        }
+        incstats_kurtosis_finalize(results, buffer_kurtosis);
+        incstats_kurtosis_log_finalize(results_log, buffer_kurtosis_log);
+        for(size_t i = 0; i < 4; i++) {
+            assert(fabs(results[i] - results_log[i]) < 1e-8);
+        }
+
+        // Weights from 1e-300 to 1e300 are compared against a two pass 
+        // computation with weights rescaled by the largest weight.
+        memset(buffer_kurtosis_log, 0, sizeof(buffer_kurtosis_log));
+        fill_random(log_weights, LENGTH_ARRAY, log(1e-300), log(1e300));
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_kurtosis_log(x[i], log_weights[i], buffer_kurtosis_log);
+            max_log_w = fmax(max_log_w, log_weights[i]);
+        }
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            weights[i] = exp(log_weights[i] - max_log_w);
+            sum_w += weights[i];
+            mean += weights[i] * x[i];
+        }
+        mean /= sum_w;
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            for(size_t j = 2; j < 5; j++) {
+                moments[j] += weights[i] * pow(x[i] - mean, j) / sum_w;
+            }
+        }
+        incstats_kurtosis_log_finalize(results_log, buffer_kurtosis_log);
+        assert(fabs(log(sum_w) + max_log_w - buffer_kurtosis_log[1]) < 1e-9);
+        assert(fabs(results_log[0] - mean) < 1e-10);
+        assert(fabs(results_log[1] - moments[2]) < 1e-10);
+        assert(fabs(buffer_kurtosis_log[4] - moments[3]) < 1e-10);
+        assert(fabs(buffer_kurtosis_log[5] - moments[4]) < 1e-10);
+    }
+}
+
+void test_incstats_variance_decay() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double tiny_weights[LENGTH_ARRAY] = {0.0};
+        double buffer[3] = {0.0};
+        double buffer_decay[4] = {0.0};
+        double buffer_unit[4] = {0.0};
+        double buffer_tiny[4] = {0.0};
+        double buffer_batch[4] = {0.0};
+        double results[2] = {0.0};
+        double results_decay[2] = {0.0};
+        double decay = 0.9;
+
+        fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            // Without decay the weighted variance is reproduced.
+            incstats_variance(x[i], weights[i], buffer);
+            incstats_variance_decay(x[i], weights[i], 1.0, buffer_decay);
+            // Weights shrinking towards the subnormal range only matter 
+            // relative to each other.
+            tiny_weights[i] = 1e-250 * pow(0.5, (double)i / 8.0);
+            incstats_variance_decay(x[i], pow(0.5, (double)i / 8.0), decay,
+                                    buffer_unit);
+            incstats_variance_decay(x[i], tiny_weights[i], decay, 
+                                    buffer_tiny);
+            assert(buffer_tiny[0] >= DBL_MIN);
+            assert(buffer_tiny[2] == 0.0 || fabs(buffer_tiny[2]) >= DBL_MIN);
+        }
+        incstats_variance_finalize(results, buffer);
+        incstats_variance_finalize(results_decay, buffer_decay);
+        assert(fabs(results[0] - results_decay[0]) < 1e-10);
+        assert(fabs(results[1] - results_decay[1]) < 1e-10);
+        assert(buffer_tiny[3] > 0.0);
+        incstats_variance_finalize(results, buffer_unit);
+        incstats_variance_finalize(results_decay, buffer_tiny);
+        assert(fabs(results[0] - results_decay[0]) < 1e-10);
+        assert(fabs(results[1] - results_decay[1]) < 1e-10);
+        incstats_variance_decay_batch(x, tiny_weights, LENGTH_ARRAY, decay,
+                                      buffer_batch);
+        assert(memcmp(buffer_batch, buffer_tiny, sizeof(buffer_tiny)) == 0);
+        // After a long stretch of zero weights the old values are negligible
+        // and the undecayed statistics of the following values are 
+        // reproduced.
+        for(size_t i = 0; i < 20000; i++) {
+            incstats_variance_decay(0.0, 0.0, 0.5, buffer_tiny);
+        }
+        assert(buffer_tiny[3] <= INCSTATS_DECAY_MAX_EXPONENT + 
+                                 INCSTATS_DECAY_RESCALE_EXPONENT);
+        memset(buffer, 0, sizeof(buffer));
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_variance(x[i], weights[i], buffer);
+            incstats_variance_decay(x[i], weights[i], 1.0, buffer_tiny);
+        }
+        incstats_variance_finalize(results, buffer);
+        incstats_variance_finalize(results_decay, buffer_tiny);
+        assert(isfinite(results_decay[0]) && isfinite(results_decay[1]));
+        assert(fabs(results[0] - results_decay[0]) < 1e-10);
+        assert(fabs(results[1] - results_decay[1]) < 1e-10);
+    }
+}
+
+void test_incstats_circular() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double theta[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double buffer[3] = {0.0};
+        double buffer_batch[3] = {0.0};
+        double buffer_other[3] = {0.0};
+        double results[4] = {0.0};
+        double results_batch[4] = {0.0};
+        double sum_w = 0.0;
+        double sum_cos = 0.0;
+        double sum_sin = 0.0;
+        double length;
+
+        // Angles scattered around 3 rad and shifted by whole turns.
+        fill_random(theta, LENGTH_ARRAY, 2.0, 4.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            double sine;
+            double cosine;
+
+            theta[i] += 2.0 * M_PI * (double)(rand() % 200 - 100);
+            incstats_fast_sincos(theta[i], &sine, &cosine);
+            assert(fabs(sine - sin(theta[i])) < 1e-10);
+            assert(fabs(cosine - cos(theta[i])) < 1e-10);
+            incstats_circular(theta[i], weights[i], buffer);
+            sum_w += weights[i];
+            sum_cos += weights[i] * cos(theta[i]);
+            sum_sin += weights[i] * sin(theta[i]);
+        }
+        incstats_circular_finalize(results, buffer);
+        length = sqrt(sum_cos * sum_cos + sum_sin * sum_sin) / sum_w;
+        assert(fabs(results[0] - atan2(sum_sin, sum_cos)) < 1e-9);
+        assert(fabs(results[0] - 3.0) < 0.1);
+        assert(fabs(results[1] - length) < 1e-9);
+        assert(fabs(results[2] - (1.0 - length)) < 1e-9);
+        assert(fabs(results[3] - sqrt(-2.0 * log(length))) < 1e-9);
+
+        incstats_circular_batch(theta, weights, LENGTH_ARRAY / 2, 
+                                buffer_batch);
+        incstats_circular_batch(&theta[LENGTH_ARRAY / 2], 
+                                &weights[LENGTH_ARRAY / 2], 
+                                LENGTH_ARRAY - LENGTH_ARRAY / 2, buffer_other);
+        incstats_circular_merge(buffer_batch, buffer_other);
+        incstats_circular_finalize(results_batch, buffer_batch);
+        for(size_t i = 0; i < 4; i++) {
+            assert(fabs(results[i] - results_batch[i]) < 1e-9);
+        }
+    }
+}
+
+void test_incstats_pca() {
+    size_t d = 4;
+    size_t k = 2;
+    size_t n = 20000;
+    // Orthonormal axes with standard deviations 3, 1 and 0.3 (the fourth 
+    // direction carries no variance) and mean (1, 2, 3, 4).
+    double axes[3][4] = {{0.5, 0.5, 0.5, 0.5}, {0.5, -0.5, 0.5, -0.5},
+                         {0.5, 0.5, -0.5, -0.5}};
+    double sigma[3] = {3.0, 1.0, 0.3};
+    double *x = malloc(n * d * sizeof(double));
+    double *weights = malloc(n * sizeof(double));
+    double buffer[1 + (2 + 2) * 4] = {0.0};
+    double buffer_mean[1 + 4] = {0.0};
+    double results[2 * (4 + 1)] = {0.0};
+
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < d; j++) {
+            x[i * d + j] = j + 1.0;
+        }
+        for(size_t a = 0; a < 3; a++) {
+            incstats_axpy(sigma[a] * random_normal(), axes[a], &x[i * d], d);
+        }
+        weights[i] = 0.5 + rand() / (double)RAND_MAX;
+        incstats_mean_vector(&x[i * d], weights[i], buffer_mean, d);
+    }
+    incstats_pca_batch(x, weights, n, buffer, d, k);
+    incstats_pca_finalize(results, buffer, d, k);
+    for(size_t j = 0; j < d + 1; j++) {
+        assert(fabs(buffer[j] - buffer_mean[j]) <= 1e-9 * buffer_mean[j]);
+    }
+    for(size_t j = 0; j < k; j++) {
+        double cosine = incstats_dot(&results[k + j * d], axes[j], d);
+        assert(fabs(fabs(cosine) - 1.0) < 1e-2);
+        assert(fabs(results[j] / (sigma[j] * sigma[j]) - 1.0) < 0.1);
+        assert(fabs(incstats_dot(&results[k + j * d], &results[k + j * d], 
+               d) - 1.0) < 1e-12);
+    }
+    free(x);
+    free(weights);
+}
+
+void solve_linear_system(double *a, double *b, size_t n) {
+    // Gaussian elimination with partial pivoting, a is row-major.
+    for(size_t j = 0; j < n; j++) {
+        size_t pivot = j;
+        for(size_t i = j + 1; i < n; i++) {
+            if(fabs(a[i * n + j]) > fabs(a[pivot * n + j])) {
+                pivot = i;
+            }
+        }
+        for(size_t l = 0; l < n; l++) {
+            double tmp = a[j * n + l];
+            a[j * n + l] = a[pivot * n + l];
+            a[pivot * n + l] = tmp;
+        }
+        double tmp = b[j];
+        b[j] = b[pivot];
+        b[pivot] = tmp;
+        for(size_t i = j + 1; i < n; i++) {
+            double factor = a[i * n + j] / a[j * n + j];
+            for(size_t l = j; l < n; l++) {
+                a[i * n + l] -= factor * a[j * n + l];
+            }
+            b[i] -= factor * b[j];
+        }
+    }
+    for(size_t j = n; j-- > 0;) {
+        for(size_t l = j + 1; l < n; l++) {
+            b[j] -= a[j * n + l] * b[l];
+        }
+        b[j] /= a[j * n + j];
+    }
+}
+
+void test_incstats_mahalanobis() {
+    size_t d = 5;
+    size_t n = LENGTH_ARRAY;
+    double *x = malloc(n * d * sizeof(double));
+    double weights[LENGTH_ARRAY] = {0.0};
+    double buffer[1 + (5 + 2) * 5] = {0.0};
+    double results[5 * (5 + 1)] = {0.0};
+    double mean[5] = {0.0};
+    double covariance[5 * 5] = {0.0};
+    double sum_w = 0.0;
+
+    fill_random(weights, n, 1e-5, 1.0);
+    for(size_t i = 0; i < n; i++) {
+        // Correlated coordinates.
+        double common = random_normal();
+        for(size_t j = 0; j < d; j++) {
+            x[i * d + j] = j + common * (j % 2 ? 1.0 : -0.5) + 
+                           (j + 1.0) * random_normal();
+        }
+        incstats_mahalanobis(&x[i * d], weights[i], buffer, d);
+        if(i < d) {
+            assert(!isfinite(incstats_mahalanobis_score(&x[i * d], buffer, 
+                   d)));
+        }
+        sum_w += weights[i];
+        incstats_axpy(weights[i], &x[i * d], mean, d);
+    }
+    incstats_scal(1.0 / sum_w, mean, d);
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < d; j++) {
+            for(size_t l = 0; l < d; l++) {
+                covariance[j * d + l] += weights[i] / sum_w * 
+                (x[i * d + j] - mean[j]) * (x[i * d + l] - mean[l]);
+            }
+        }
+    }
+    incstats_mahalanobis_finalize(results, buffer, d);
+    for(size_t j = 0; j < d; j++) {
+        assert(fabs(results[j] - mean[j]) < 1e-9);
+    }
+    for(size_t j = 0; j < d * d; j++) {
+        assert(fabs(results[d + j] - covariance[j]) < 1e-9);
+    }
+    for(size_t i = 0; i < 100; i++) {
+        double a[5 * 5];
+        double delta[5];
+        double solution[5];
+        double distance;
+
+        memcpy(a, covariance, sizeof(a));
+        for(size_t j = 0; j < d; j++) {
+            delta[j] = x[i * d + j] - mean[j];
+            solution[j] = delta[j];
+        }
+        solve_linear_system(a, solution, d);
+        distance = sqrt(incstats_dot(delta, solution, d));
+        assert(fabs(incstats_mahalanobis_score(&x[i * d], buffer, d) - 
+               distance) < 1e-9 * distance);
+    }
+    free(x);
+}
+
+void test_incstats_comoment() {
+    size_t d = 3;
+    size_t s2 = 6;
+    size_t s3 = 10;
+    size_t s4 = 15;
+    size_t length = 1 + 2 * 3 + 6 + 10 + 15;
+    size_t n = LENGTH_ARRAY;
+    double *x = malloc(n * d * sizeof(double));
+    double weights[LENGTH_ARRAY] = {0.0};
+    double buffer[1 + 2 * 3 + 6 + 10 + 15] = {0.0};
+    double buffer_a[1 + 2 * 3 + 6 + 10 + 15] = {0.0};
+    double buffer_b[1 + 2 * 3 + 6 + 10 + 15] = {0.0};
+    double results[3 + 6 + 10 + 15] = {0.0};
+    double results_merged[3 + 6 + 10 + 15] = {0.0};
+    double standardized[3 + 6 + 10 + 15] = {0.0};
+    double mean[3] = {0.0};
+    double sum_w = 0.0;
+    bool seen[15] = {false};
+
+    fill_random(weights, n, 1e-5, 1.0);
+    for(size_t i = 0; i < n; i++) {
+        double common = random_normal();
+        for(size_t j = 0; j < d; j++) {
+            x[i * d + j] = j + common + exp(0.5 * j * random_normal());
+        }
+        incstats_comoment(&x[i * d], weights[i], buffer, d);
+        incstats_comoment(&x[i * d], weights[i], i < n / 3 ? buffer_a : 
+                          buffer_b, d);
+        sum_w += weights[i];
+        incstats_axpy(weights[i], &x[i * d], mean, d);
+    }
+    incstats_scal(1.0 / sum_w, mean, d);
+    incstats_comoment_merge(buffer_a, buffer_b, d);
+    incstats_comoment_finalize(results, buffer, d, false);
+    incstats_comoment_finalize(results_merged, buffer_a, d, false);
+    incstats_comoment_finalize(standardized, buffer, d, true);
+    for(size_t i = 0; i < length - 1 - d; i++) {
+        assert(fabs(results[i] - results_merged[i]) <= 
+               1e-9 * (fabs(results[i]) + 1.0));
+    }
+    for(size_t i = 0; i < d; i++) {
+        assert(fabs(results[i] - mean[i]) < 1e-9);
+    }
+    for(size_t order = 2; order <= 4; order++) {
+        size_t offset = d + (order > 2 ? s2 : 0) + (order > 3 ? s3 : 0);
+        size_t count = order == 2 ? s2 : order == 3 ? s3 : s4;
+        size_t indices[4] = {0};
+
+        // Visit all index tuples, including unsorted ones.
+        for(size_t t = 0; t < (size_t)pow(d, order); t++) {
+            size_t rest = t;
+            size_t position;
+            double moment = 0.0;
+            double norm = 1.0;
+
+            for(size_t a = 0; a < order; a++) {
+                indices[a] = rest % d;
+                rest /= d;
+                norm *= sqrt(results[d + indices[a] * (indices[a] + 3) / 2]);
+            }
+            position = incstats_symmetric_index(indices, order);
+            assert(position < count);
+            if(order == 4) {
+                seen[position] = true;
+            }
+            for(size_t i = 0; i < n; i++) {
+                double product = weights[i] / sum_w;
+                for(size_t a = 0; a < order; a++) {
+                    product *= x[i * d + indices[a]] - mean[indices[a]];
+                }
+                moment += product;
+            }
+            assert(fabs(results[offset + position] - moment) <= 
+                   1e-9 * (fabs(moment) + 1.0));
+            if(order > 2) {
+                assert(fabs(standardized[offset + position] - moment / norm)
+                       <= 1e-9 * (fabs(moment / norm) + 1.0));
+            }
+        }
+    }
+    for(size_t i = 0; i < s4; i++) {
+        assert(seen[i]);
+    }
+    free(x);
+}
+
+void test_incstats_variance_merge() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double buffer[3] = {0.0};
+        double buffer_a[3] = {0.0};
+        double buffer_b[3] = {0.0};
+        size_t split = rand() % LENGTH_ARRAY;
+
+        fill_random(x, LENGTH_ARRAY, 0.0, 1.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_variance(x[i], weights[i], buffer);
+            incstats_variance(x[i], weights[i], i < split ? buffer_a : 
+                              buffer_b);
+        }
+        incstats_variance_merge(buffer_a, buffer_b);
+        for(size_t i = 0; i < 3; i++) {
+            assert(fabs(buffer[i] - buffer_a[i]) <= 1e-10 * fabs(buffer[i]));
+        }
+    }
+}
+
+void test_incstats_gmm() {
+    uint64_t k = 3;
+    double centers[3] = {-6.0, 0.0, 5.0};
+    double sigmas[3] = {1.0, 0.5, 1.5};
+    double mixing[3] = {0.5, 0.2, 0.3};
+    double buffer[3 + 4 * 3] = {0.0};
+    double buffer_shard[3 + 4 * 3] = {0.0};
+    double results[3 * 3] = {0.0};
+
+    // One rough representative per mode seeds the components of each shard.
+    for(size_t c = 0; c < k; c++) {
+        incstats_gmm(centers[c] + 0.3, 1.0, buffer, k);
+        incstats_gmm(centers[k - 1 - c] - 0.3, 1.0, buffer_shard, k);
+    }
+    for(size_t i = 0; i < 40000; i++) {
+        double u = rand() / (double)RAND_MAX;
+        size_t c = u < mixing[0] ? 0 : u < mixing[0] + mixing[1] ? 1 : 2;
+        double x = centers[c] + sigmas[c] * random_normal();
+        incstats_gmm(x, 1.0, i % 2 ? buffer : buffer_shard, k);
+    }
+    incstats_gmm_merge(buffer, buffer_shard, k);
+    incstats_gmm_finalize(results, buffer, k);
+    assert(buffer[0] == 40000.0 + 2 * k);
+    for(size_t c = 0; c < k; c++) {
+        bool matched = false;
+        for(size_t j = 0; j < k; j++) {
+            if(fabs(results[3 * j + 1] - centers[c]) < 0.1) {
+                assert(fabs(results[3 * j] - mixing[c]) < 0.02);
+                assert(fabs(sqrt(results[3 * j + 2]) - sigmas[c]) < 0.1);
+                matched = true;
+            }
+        }
+        assert(matched);
+    }
+}
+
+void test_incstats_kmeans() {
+    size_t k = 3;
+    size_t d = 2;
+    size_t batch = 100;
+    double centers[3][2] = {{-5.0, 1.0}, {0.0, 8.0}, {6.0, -2.0}};
+    double buffer[3 * (1 + 2 * 2)] = {0.0};
+    double buffer_batch[3 * (1 + 2 * 2)] = {0.0};
+    double results[3 * (1 + 2 * 2)] = {0.0};
+    double reference[3][2][3] = {{{0.0}}};
+    double x[100 * 2];
+    double w[100];
+    size_t labels[100];
+    size_t labels_batch[100];
+
+    for(size_t b = 0; b < 200; b++) {
+        for(size_t i = 0; i < batch; i++) {
+            // Seed with one vector per cluster at the start of each half of 
+            // the first batch.
+            size_t c = b == 0 && i % (batch / 2) < k ? i % (batch / 2) : 
+                       rand() % k;
+            x[i * d] = centers[c][0] + random_normal();
+            x[i * d + 1] = centers[c][1] + random_normal();
+            w[i] = 1.0 + rand() % 3;
+        }
+        // Assign two halves independently as two threads would, starting 
+        // from the zeroed model.
+        incstats_kmeans_assign(labels, x, batch / 2, buffer, d, k);
+        incstats_kmeans_assign(&labels[batch / 2], &x[batch / 2 * d], 
+                               batch - batch / 2, buffer, d, k);
+        if(b == 0) {
+            for(size_t i = 0; i < batch; i++) {
+                size_t c = i % (batch / 2);
+                assert(c >= k || labels[i] == c);
+            }
+        }
+        incstats_kmeans_update(x, w, labels, batch, buffer, d, k);
+        incstats_kmeans_batch(x, w, labels_batch, batch, buffer_batch, d, k);
+        for(size_t i = 0; i < batch; i++) {
+            assert(labels[i] < k);
+            for(size_t j = 0; j < d; j++) {
+                incstats_variance(x[i * d + j], w[i], reference[labels[i]][j]);
+            }
+        }
+    }
+    for(size_t m = 0; m < 2; m++) {
+        incstats_kmeans_finalize(results, m == 0 ? buffer : buffer_batch, d, 
+                                 k);
+        for(size_t c = 0; c < k; c++) {
+            double *result = &results[c * (1 + 2 * d)];
+            for(size_t j = 0; j < d; j++) {
+                double variance[2];
+                incstats_variance_finalize(variance, reference[c][j]);
+                if(m == 0) {
+                    assert(result[0] == reference[c][j][0]);
+                    assert(fabs(result[1 + j] - variance[0]) <= 1e-10);
+                    assert(fabs(result[1 + d + j] - variance[1]) <= 1e-10);
+                }
+                assert(fabs(result[1 + j] - centers[c][j]) < 0.1);
+                assert(fabs(result[1 + d + j] - 1.0) < 0.1);
+            }
+        }
+    }
+}
+
+void test_incstats_normal_quantile() {
+    assert(fabs(incstats_normal_quantile(0.975) - 1.959963984540054) < 1e-14);
+    assert(incstats_normal_quantile(0.5) == 0.0);
+    assert(isinf(incstats_normal_quantile(0.0)));
+    assert(isnan(incstats_normal_quantile(1.5)));
+    for(size_t i = 1; i < 1000; i++) {
+        double p = i / 1000.0;
+        double tail = pow(10.0, -(double)i / 50.0);
+        double z = incstats_normal_quantile(p);
+        assert(fabs(0.5 * erfc(-z / sqrt(2.0)) - p) <= 1e-15);
+        assert(fabs(incstats_normal_quantile(1.0 - p) + z) <= 1e-12);
+        // Deep in the lower tail the relative error stays small.
+        z = incstats_normal_quantile(tail);
+        assert(fabs(0.5 * erfc(-z / sqrt(2.0)) - tail) <= 1e-13 * tail);
+    }
+}
+
+void test_incstats_kurtosis_quantile() {
+    size_t n = 3;
+    double probabilities[5] = {0.01, 0.1, 0.5, 0.9, 0.99};
+    double buffers[3 * 5] = {0.0};
+    double results[3 * 5];
+    double quantiles[5];
+
+    // Gamma distributions with shape 1, 4 and 16 as sums of exponentials and
+    // their exact quantiles.
+    double shapes[3] = {1.0, 4.0, 16.0};
+    double exact[3][5] = {
+        {0.0100503, 0.1053605, 0.6931472, 2.3025851, 4.6051702},
+        {0.8232487, 1.7447696, 3.6720607, 6.6807831, 10.0451175},
+        {8.1811078, 11.1352972, 15.6679295, 21.2923725, 26.7428859}};
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < 200000; j++) {
+            double x = 0.0;
+            for(size_t s = 0; s < shapes[i]; s++) {
+                x -= log((rand() + 1.0) / (RAND_MAX + 2.0));
+            }
+            incstats_kurtosis(x, 1.0, &buffers[5 * i]);
+        }
+    }
+    incstats_kurtosis_quantile_finalize_bulk(results, buffers, n, 
+                                             probabilities, 5);
+    for(size_t i = 0; i < n; i++) {
+        incstats_kurtosis_quantile_finalize(quantiles, &buffers[5 * i], 
+                                            probabilities, 5);
+        for(size_t j = 0; j < 5; j++) {
+            double error = fabs(quantiles[j] - exact[i][j]) / sqrt(shapes[i]);
+            assert(fabs(results[5 * i + j] - quantiles[j]) <= 
+                   1e-12 * fabs(quantiles[j]));
+            // The expansion improves as the distribution approaches normal.
+            assert(error < (i == 0 ? 0.25 : 0.03));
+        }
+    }
+}
+
+void test_incstats_central_moment_quantile_maxent() {
+    double probabilities[5] = {0.01, 0.1, 0.5, 0.9, 0.99};
+    double buffer[7] = {0.0};
+    double buffer_uniform[9] = {0.0};
+    double results[5];
+
+    for(size_t i = 0; i < 200000; i++) {
+        incstats_central_moment(3.0 + 2.0 * random_normal(), 1.0, buffer, 6);
+        incstats_central_moment(rand() / (double)RAND_MAX, 1.0, 
+                                buffer_uniform, 8);
+    }
+    // With four moments of a normal the maximum entropy density is normal.
+    assert(incstats_central_moment_quantile_maxent(results, buffer, 4, -9.0, 
+                                                   15.0, probabilities, 5));
+    for(size_t j = 0; j < 5; j++) {
+        double z = incstats_normal_quantile(probabilities[j]);
+        assert(fabs(results[j] - (3.0 + 2.0 * z)) < 0.05);
+    }
+    assert(incstats_central_moment_quantile_maxent(results, buffer, 6, -9.0, 
+                                                   15.0, probabilities, 5));
+    for(size_t j = 0; j < 5; j++) {
+        double z = incstats_normal_quantile(probabilities[j]);
+        assert(fabs(results[j] - (3.0 + 2.0 * z)) < 0.05);
+    }
+    assert(incstats_central_moment_quantile_maxent(results, buffer_uniform, 8, 
+                                                   0.0, 1.0, probabilities, 
+                                                   5));
+    for(size_t j = 0; j < 5; j++) {
+        assert(fabs(results[j] - probabilities[j]) < 0.01);
+    }
+    assert(!incstats_central_moment_quantile_maxent(results, buffer, 4, 1.0, 
+                                                    1.0, probabilities, 5));
+    assert(!incstats_central_moment_quantile_maxent(
+        results, buffer, INCSTATS_MAXENT_MAX_ORDER + 1, -9.0, 15.0, 
+        probabilities, 5));
+}
+
+void test_incstats_drift() {
+    uint64_t counts[2] = {1, 3};
+    uint64_t reference[2] = {2, 2};
+    uint64_t histogram[256] = {0};
+    uint64_t histogram_reference[256] = {0};
+    double buffer[5] = {0.0};
+    double buffer_reference[5] = {0.0};
+    // Today's data is N(0.5, 1.2^2), yesterday's N(0, 1).
+    double kl = -log(1.2) + (1.44 + 0.25) / 2.0 - 0.5;
+    double hellinger = sqrt(1.0 - sqrt(2.0 * 1.2 / 2.44) * 
+                            exp(-0.25 * 0.25 / 2.44));
+
+    assert(fabs(incstats_histogram_psi(counts, reference, 2, 0.0) - 
+                0.25 * log(3.0)) < 1e-15);
+    assert(fabs(incstats_histogram_kl(counts, reference, 2, 0.0) - 
+                (0.25 * log(0.5) + 0.75 * log(1.5))) < 1e-15);
+    assert(fabs(incstats_histogram_hellinger(counts, reference, 2) - 
+                sqrt(1.0 - sqrt(0.125) - sqrt(0.375))) < 1e-15);
+    assert(incstats_histogram_psi(counts, counts, 2, 0.5) == 0.0);
+    assert(incstats_histogram_hellinger(counts, counts, 2) == 0.0);
+    // Smoothing keeps bins that are empty in only one histogram finite.
+    counts[0] = 0;
+    assert(isinf(incstats_histogram_kl(reference, counts, 2, 0.0)));
+    assert(isfinite(incstats_histogram_psi(reference, counts, 2, 0.5)));
+
+    for(size_t i = 0; i < 400000; i++) {
+        double x = 0.5 + 1.2 * random_normal();
+        double y = random_normal();
+        // Bins of width 1/16 over [-8, 8].
+        histogram[(size_t)fmin(fmax(floor((x + 8.0) * 16.0), 0.0), 255.0)]++;
+        histogram_reference[(size_t)fmin(fmax(floor((y + 8.0) * 16.0), 0.0), 
+                                         255.0)]++;
+        incstats_kurtosis(x, 1.0, buffer);
+        incstats_kurtosis(y, 1.0, buffer_reference);
+    }
+    assert(fabs(incstats_kurtosis_kl(buffer, buffer_reference) - kl) < 0.01);
+    assert(fabs(incstats_kurtosis_hellinger(buffer, buffer_reference) - 
+                hellinger) < 0.01);
+    assert(incstats_kurtosis_kl(buffer, buffer) == 0.0);
+    assert(incstats_kurtosis_hellinger(buffer, buffer) == 0.0);
+    // The binned divergences approach the ones of the densities.
+    assert(fabs(incstats_histogram_kl(histogram, histogram_reference, 256, 
+                                      0.5) - kl) < 0.02);
+    assert(fabs(incstats_histogram_hellinger(histogram, histogram_reference, 
+                                             256) - hellinger) < 0.02);
+    assert(fabs(incstats_histogram_psi(histogram, histogram_reference, 256, 
+                                       0.5) - 
+                (kl + incstats_kurtosis_kl(buffer_reference, buffer))) < 0.05);
+}
+
+void test_incstats_histogram_distance() {
+    uint64_t counts[256] = {0};
+    uint64_t reference[256] = {0};
+    uint64_t shifted[256] = {0};
+    double results[2];
+    double swapped[2];
+
+    for(size_t i = 0; i < 100000; i++) {
+        size_t v = rand() % 200;
+        counts[v]++;
+        shifted[v + 7]++;
+        reference[rand() % 256]++;
+    }
+    // A shift by 7 bins moves all mass by 7.
+    incstats_histogram_distance_finalize(results, shifted, counts, 256);
+    assert(fabs(results[1] - 7.0) < 1e-9);
+    assert(results[0] > 0.03 && results[0] < 0.04);
+    incstats_histogram_distance_finalize(results, counts, counts, 256);
+    assert(results[0] == 0.0 && results[1] == 0.0);
+    // Uniform on [0, 199] against uniform on [0, 255]: the distribution 
+    // functions differ most at 199 by 1 - 200 / 256, and the area between 
+    // them is half the difference of the widths, 56 / 2 = 28.
+    incstats_histogram_distance_finalize(results, counts, reference, 256);
+    assert(fabs(results[0] - 56.0 / 256.0) < 0.01);
+    assert(fabs(results[1] - 28.0) < 1.0);
+    // The distances are symmetric.
+    incstats_histogram_distance_finalize(swapped, reference, counts, 256);
+    assert(swapped[0] == results[0] && swapped[1] == results[1]);
+}
+
+void test_incstats_allan() {
+    size_t levels = 10;
+    size_t n = 1 << 20;
+    double buffer[6 * 10] = {0.0};
+    double buffer_small[6 * 4] = {0.0};
+    double results[2 * 10];
+    double y[1000];
+
+    // White frequency noise has an Allan variance of 1 / m at m * tau0.
+    for(size_t i = 0; i < n; i++) {
+        incstats_allan(random_normal(), buffer, levels);
+    }
+    incstats_allan_finalize(results, buffer, levels);
+    for(size_t j = 0; j < levels; j++) {
+        double m = (double)(1 << j);
+        assert(results[2 * j + 1] == (double)(n >> j) - 1.0);
+        assert(fabs(results[2 * j] * m - 1.0) < 0.15);
+    }
+
+    // Compare against the block averages computed offline, including 
+    // incomplete blocks at the end which must be ignored.
+    fill_random(y, 1000, -1.0, 1.0);
+    for(size_t i = 0; i < 1000; i++) {
+        y[i] += 1e-3 * (double)i;
+        incstats_allan(y[i], buffer_small, 4);
+    }
+    incstats_allan_finalize(results, buffer_small, 4);
+    for(size_t j = 0; j < 4; j++) {
+        size_t m = (size_t)1 << j;
+        size_t blocks = 1000 / m;
+        double sum = 0.0;
+        double previous = 0.0;
+        for(size_t b = 0; b < blocks; b++) {
+            double average = 0.0;
+            for(size_t i = 0; i < m; i++) {
+                average += y[b * m + i];
+            }
+            average /= (double)m;
+            if(b > 0) {
+                sum += (average - previous) * (average - previous);
+            }
+            previous = average;
+        }
+        assert(results[2 * j + 1] == (double)(blocks - 1));
+        assert(fabs(results[2 * j] - 0.5 * sum / (double)(blocks - 1)) <= 
+               1e-12 * results[2 * j]);
+    }
+}
+
+void test_incstats_joint_histogram() {
+    size_t n = 400;
+    size_t bins = 64;
+    double x[400];
+    double y[400];
+    double w[400];
+    double *buffer = malloc((5 + 64 * 64) * sizeof(double));
+    double *buffer_shard = malloc((5 + 64 * 64) * sizeof(double));
+    double *buffer_batch = malloc((5 + 64 * 64) * sizeof(double));
+    double scratch[3 * 64];
+    double results[2];
+    double results_batch[2];
+    double rank_x[400];
+    double rank_y[400];
+    double mean_rank = 0.5 * (n + 1);
+    double covariance = 0.0;
+    double variance_x = 0.0;
+    double variance_y = 0.0;
+    double concordance = 0.0;
+    double untied_x = 0.0;
+    double untied_y = 0.0;
+    double spearman;
+    double tau;
+
+    // Integers fall into one bin each, so the binned ranks are exact.
+    for(size_t i = 0; i < n; i++) {
+        x[i] = rand() % bins;
+        y[i] = fmod(x[i] * 7.0 + rand() % 20, (double)bins);
+        w[i] = 1.0;
+    }
+    incstats_joint_histogram_init(buffer, bins, 0.0, bins, 0.0, bins);
+    incstats_joint_histogram_init(buffer_shard, bins, 0.0, bins, 0.0, bins);
+    incstats_joint_histogram_init(buffer_batch, bins, 0.0, bins, 0.0, bins);
+    for(size_t i = 0; i < n; i++) {
+        incstats_joint_histogram(x[i], y[i], 1.0, 
+                                 i < n / 3 ? buffer_shard : buffer);
+    }
+    incstats_joint_histogram_merge(buffer, buffer_shard);
+    incstats_joint_histogram_batch(x, y, w, n, buffer_batch);
+    assert(memcmp(buffer, buffer_batch, 
+                  (5 + bins * bins) * sizeof(double)) == 0);
+    incstats_joint_histogram_correlation_finalize(results, buffer, scratch);
+    incstats_joint_histogram_correlation_finalize(results_batch, buffer_batch,
+                                                  scratch);
+
+    // Reference midranks and the quadratic tau-b with ties.
+    for(size_t i = 0; i < n; i++) {
+        double less_x = 0.0;
+        double equal_x = 0.0;
+        double less_y = 0.0;
+        double equal_y = 0.0;
+        for(size_t j = 0; j < n; j++) {
+            less_x += x[j] < x[i];
+            equal_x += x[j] == x[i];
+            less_y += y[j] < y[i];
+            equal_y += y[j] == y[i];
+        }
+        rank_x[i] = less_x + 0.5 * (equal_x + 1.0);
+        rank_y[i] = less_y + 0.5 * (equal_y + 1.0);
+    }
+    for(size_t i = 0; i < n; i++) {
+        covariance += (rank_x[i] - mean_rank) * (rank_y[i] - mean_rank);
+        variance_x += (rank_x[i] - mean_rank) * (rank_x[i] - mean_rank);
+        variance_y += (rank_y[i] - mean_rank) * (rank_y[i] - mean_rank);
+    }
+    spearman = covariance / sqrt(variance_x * variance_y);
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = i + 1; j < n; j++) {
+            double sign_x = (x[i] > x[j]) - (x[i] < x[j]);
+            double sign_y = (y[i] > y[j]) - (y[i] < y[j]);
+            concordance += sign_x * sign_y;
+            untied_x += sign_x != 0.0;
+            untied_y += sign_y != 0.0;
+        }
+    }
+    tau = concordance / sqrt(untied_x * untied_y);
+    assert(fabs(results[0] - spearman) < 1e-12);
+    assert(fabs(results[1] - tau) < 1e-12);
+    assert(results_batch[0] == results[0] && results_batch[1] == results[1]);
+    // Monotone transforms do not change the ranks.
+    incstats_joint_histogram_init(buffer, bins, 0.0, 1.0, -1.0, 0.0);
+    for(size_t i = 0; i < n; i++) {
+        double u = rand() / (RAND_MAX + 1.0);
+        incstats_joint_histogram(u, -sqrt(u), 1.0, buffer);
+    }
+    incstats_joint_histogram_correlation_finalize(results, buffer, scratch);
+    assert(results[0] < -0.99 && results[1] < -0.95);
+    free(buffer);
+    free(buffer_shard);
+    free(buffer_batch);
+}
+
+void test_incstats_joint_histogram_entropy() {
+    size_t bins = 64;
+    size_t n = 1000;
+    double rho = 0.8;
+    double mutual_information = -0.5 * log(1.0 - rho * rho);
+    double *buffer = malloc((5 + 64 * 64) * sizeof(double));
+    double *buffer_log = malloc((5 + 64 * 64) * sizeof(double));
+    double *buffer_batch = malloc((5 + 64 * 64) * sizeof(double));
+    double x[1000];
+    double y[1000];
+    double w[1000];
+    size_t cells[1000];
+    double results[4];
+
+    assert(incstats_log_linear(8.0) == 3.0);
+    assert(incstats_log_linear(0.25) == -2.0);
+    assert(incstats_log_linear(3.0) == 1.5);
+
+    // One pair per cell: the marginals are uniform and independent.
+    incstats_joint_histogram_init(buffer, bins, 0.0, bins, 0.0, bins);
+    for(size_t i = 0; i < bins; i++) {
+        for(size_t j = 0; j < bins; j++) {
+            incstats_joint_histogram(i + 0.5, j + 0.5, 2.0, buffer);
+        }
+    }
+    incstats_joint_histogram_entropy_finalize(results, buffer);
+    assert(fabs(results[0] - log(bins)) < 1e-12);
+    assert(fabs(results[1] - log(bins)) < 1e-12);
+    assert(fabs(results[2] - 2.0 * log(bins)) < 1e-12);
+    assert(fabs(results[3]) < 1e-12);
+
+    // Correlated normals, and their exponentials on log-linear bins, have 
+    // the mutual information -ln(1 - rho^2) / 2.
+    incstats_joint_histogram_init(buffer, bins, -5.0, 5.0, -5.0, 5.0);
+    incstats_joint_histogram_init(buffer_log, bins, exp(-5.0), exp(5.0), 
+                                  exp(-5.0), exp(5.0));
+    incstats_joint_histogram_init(buffer_batch, bins, exp(-5.0), exp(5.0), 
+                                  exp(-5.0), exp(5.0));
+    for(size_t b = 0; b < 1000; b++) {
+        for(size_t i = 0; i < n; i++) {
+            double u = random_normal();
+            double v = rho * u + sqrt(1.0 - rho * rho) * random_normal();
+            incstats_joint_histogram(u, v, 1.0, buffer);
+            incstats_joint_histogram_log(exp(u), exp(v), 1.0, buffer_log);
+            x[i] = exp(u);
+            y[i] = exp(v);
+            w[i] = 1.0;
+        }
+        incstats_joint_histogram_log_batch(x, y, w, n, buffer_batch, cells);
+    }
+    incstats_joint_histogram_entropy_finalize(results, buffer);
+    assert(fabs(results[3] - mutual_information) < 0.02);
+    incstats_joint_histogram_entropy_finalize(results, buffer_log);
+    assert(fabs(results[3] - mutual_information) < 0.03);
+    // Values out of range and not positive land in the edge bins.
+    incstats_joint_histogram_log(-1.0, 1e9, 1.0, buffer_log);
+    assert(buffer_log[5 + bins - 1] >= 1.0);
+    x[0] = -1.0;
+    y[0] = 1e9;
+    incstats_joint_histogram_log_batch(x, y, w, 1, buffer_batch, cells);
+    assert(memcmp(buffer_log, buffer_batch, 
+                  (5 + bins * bins) * sizeof(double)) == 0);
+    free(buffer);
+    free(buffer_log);
+    free(buffer_batch);
+}
+
+void test_incstats_holt_winters() {
+    size_t m = 3;
+    size_t n = 5;
+    double pattern[3] = {3.0, -1.0, -2.0};
+    double buffer[3 + 3] = {0.0};
+    double buffers[5][3 + 3] = {{0.0}};
+    double bank[3 + 3][5] = {{0.0}};
+    double *columns[3 + 3];
+    double x[5];
+    double results[7];
+
+    for(size_t j = 0; j < 3 + m; j++) {
+        columns[j] = bank[j];
+    }
+    // A noise free series with a linear trend and a season of length 3.
+    for(size_t t = 0; t < 300; t++) {
+        incstats_holt_winters(10.0 + 0.5 * t + pattern[t % m], buffer, 0.5, 
+                              0.3, 0.3, m);
+        for(size_t i = 0; i < n; i++) {
+            x[i] = random_normal() + (double)i;
+            incstats_holt_winters(x[i], buffers[i], 0.4, 0.1, 0.2, m);
+        }
+        incstats_holt_winters_soa(x, columns, n, 0.4, 0.1, 0.2, m);
+    }
+    incstats_holt_winters_finalize(results, buffer, m, 7);
+    for(size_t h = 1; h <= 7; h++) {
+        double t = 299.0 + h;
+        assert(fabs(results[h - 1] - (10.0 + 0.5 * t + 
+                                      pattern[(299 + h) % m])) < 1e-6);
+    }
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < 3 + m; j++) {
+            assert(fabs(bank[j][i] - buffers[i][j]) <= 
+                   1e-12 * (1.0 + fabs(buffers[i][j])));
+        }
+    }
+}
+
+void test_incstats_kalman() {
+    size_t n = 4;
+    double buffer[3] = {0.0};
+    double buffer_mean[3] = {0.0};
+    double buffers[4][3] = {{0.0}};
+    double bank[3][4] = {{0.0}};
+    double *columns[3] = {bank[0], bank[1], bank[2]};
+    double z[4];
+    double results[2];
+
+    for(size_t t = 0; t < 1000; t++) {
+        double measurement = 5.0 + 2.0 * random_normal();
+        // Without process noise the filter is the running mean.
+        incstats_kalman(measurement, buffer, 0.0, 4.0);
+        incstats_variance(measurement, 1.0, buffer_mean);
+    }
+    incstats_kalman_finalize(results, buffer);
+    assert(fabs(results[0] - buffer_mean[1]) < 1e-12);
+    assert(fabs(results[1] - 4.0 / 1000.0) < 1e-15);
+    // A bank of filters matches the scalar filters.
+    for(size_t t = 0; t < 100; t++) {
+        for(size_t i = 0; i < n; i++) {
+            z[i] = (double)i + random_normal();
+            incstats_kalman(z[i], buffers[i], 0.1, 2.0);
+        }
+        incstats_kalman_soa(z, columns, n, 0.1, 2.0);
+    }
+    for(size_t i = 0; i < n; i++) {
+        for(size_t j = 0; j < 3; j++) {
+            assert(fabs(bank[j][i] - buffers[i][j]) <= 
+                   1e-12 * (1.0 + fabs(buffers[i][j])));
+        }
+    }
+}
+
+void test_incstats_kurtosis_merge() {
+    for(size_t k = 0; k < ITERATIONS_TEST; k++) {
+        double x[LENGTH_ARRAY] = {0.0};
+        double weights[LENGTH_ARRAY] = {0.0};
+        double buffer[5] = {0.0};
+        double buffer_a[5] = {0.0};
+        double buffer_b[5] = {0.0};
+        double results[4];
+        double results_merged[4];
+        size_t split = rand() % LENGTH_ARRAY;
+
+        fill_random(x, LENGTH_ARRAY, -10.0, 20.0);
+        fill_random(weights, LENGTH_ARRAY, 1e-5, 1.0);
+        for(size_t i = 0; i < LENGTH_ARRAY; i++) {
+            incstats_kurtosis(x[i], weights[i], buffer);
+            incstats_kurtosis(x[i], weights[i], i < split ? buffer_a : 
+                              buffer_b);
+        }
+        incstats_kurtosis_merge(buffer_a, buffer_b);
+        incstats_kurtosis_finalize(results, buffer);
+        incstats_kurtosis_finalize(results_merged, buffer_a);
+        assert(fabs(buffer[0] - buffer_a[0]) <= 1e-12 * buffer[0]);
+        for(size_t i = 0; i < 4; i++) {
+            assert(fabs(results[i] - results_merged[i]) <= 
+                   1e-9 * (1.0 + fabs(results[i])));
+        }
+    }
+}
+
+void test_incstats_table() {
+    incstats_table table;
+    incstats_table table_b;
+    incstats_budget budget = {0, 0};
+    double *reference = calloc(5 * 5000, sizeof(double));
+    double all[5] = {0.0};
+    double merged[5] = {0.0};
+    double results[4];
+    double results_merged[4];
+    size_t bytes;
+
+    // Without a budget the table holds every key.
+    assert(incstats_table_init(&table, 5, incstats_kurtosis, 
+                               incstats_kurtosis_merge, NULL));
+    for(size_t i = 0; i < 100000; i++) {
+        size_t k = rand() % 5000;
+        double x = rand() / (double)RAND_MAX;
+        // Spread keys are hashed like sequential ones.
+        assert(incstats_table_update(&table, k * 0x9e3779b97f4a7c15ULL, x, 
+                                     1.0) != NULL);
+        incstats_kurtosis(x, 1.0, &reference[5 * k]);
+    }
+    for(size_t k = 0; k < 5000; k++) {
+        double *state = incstats_table_find(&table, 
+                                            k * 0x9e3779b97f4a7c15ULL);
+        if(reference[5 * k] == 0.0) {
+            assert(state == NULL);
+            continue;
+        }
+        assert(memcmp(state, &reference[5 * k], 5 * sizeof(double)) == 0);
+    }
+    incstats_table_free(&table);
+
+    // Keys beyond the budget evict the least recently updated keys.
+    assert(incstats_table_init(&table, 5, incstats_kurtosis, 
+                               incstats_kurtosis_merge, &budget));
+    bytes = incstats_table_entry_bytes(&table);
+    budget.limit = 100 * bytes;
+    for(uint64_t key = 0; key < 200; key++) {
+        double x = random_normal();
+        incstats_table_update(&table, key, x, 1.0);
+        incstats_kurtosis(x, 1.0, all);
+    }
+    assert(table.count == 100 && table.evictions == 100);
+    assert(budget.used == 100 * bytes);
+    assert(incstats_table_find(&table, 99) == NULL);
+    assert(incstats_table_find(&table, 100) != NULL);
+    incstats_table_update(&table, 100, 0.5, 1.0);
+    incstats_kurtosis(0.5, 1.0, all);
+    incstats_table_update(&table, 200, 0.5, 1.0);
+    incstats_kurtosis(0.5, 1.0, all);
+    assert(incstats_table_find(&table, 100) != NULL);
+    assert(incstats_table_find(&table, 101) == NULL);
+    assert(table.keys[table.head] == 200);
+    assert(table.keys[table.tail] == 102);
+
+    // A second table sharing the spent budget has no key to evict and counts
+    // new keys in its other bucket. Lowering the limit evicts more keys.
+    assert(incstats_table_init(&table_b, 5, incstats_kurtosis, 
+                               incstats_kurtosis_merge, &budget));
+    assert(incstats_table_update(&table_b, 7, 1.0, 1.0) == table_b.other);
+    assert(table_b.count == 0);
+    budget.limit = 60 * bytes;
+    assert(incstats_table_enforce(&table) == 40);
+    assert(table.count == 60 && budget.used == 60 * bytes);
+    budget.limit = 61 * bytes;
+    assert(incstats_table_update(&table_b, 7, 1.0, 1.0) != table_b.other);
+    assert(table.count == 60 && table_b.count == 1);
+    assert(table_b.other[0] == 1.0 && table_b.states[0] == 1.0);
+
+    // No value is lost: the kept keys and the other bucket merge to the 
+    // statistics of all values.
+    memcpy(merged, table.other, sizeof(merged));
+    for(size_t i = 0; i < table.count; i++) {
+        incstats_kurtosis_merge(merged, &table.states[5 * i]);
+    }
+    incstats_kurtosis_finalize(results, all);
+    incstats_kurtosis_finalize(results_merged, merged);
+    assert(merged[0] == all[0]);
+    for(size_t i = 0; i < 4; i++) {
+        assert(fabs(results[i] - results_merged[i]) <= 
+               1e-9 * (1.0 + fabs(results[i])));
+    }
+    incstats_table_free(&table);
+    incstats_table_free(&table_b);
+    assert(budget.used == 0);
+    free(reference);
+}
+
+void test_incstats_table_expire() {
+    incstats_table table;
+    incstats_budget budget = {SIZE_MAX, 0};
+    char path[] = "incstats_table_spill.bin";
+    char path_short[] = "incstats_table_spill_short.bin";
+    double reference[50][3] = {{0.0}};
+    double all[3] = {0.0};
+    double merged[3] = {0.0};
+    char bytes[256];
+    size_t length;
+    FILE *spill;
+    FILE *file;
+
+    // Without a spill file expired keys are merged into the other bucket.
+    assert(incstats_table_init(&table, 3, incstats_variance, 
+                               incstats_variance_merge, &budget));
+    for(uint64_t key = 0; key < 10; key++) {
+        incstats_table_set_time(&table, (double)key);
+        incstats_table_update(&table, key, (double)key, 1.0);
+    }
+    incstats_table_set_time(&table, 12.0);
+    assert(incstats_table_expire(&table, 5.0) == 7);
+    assert(table.count == 3 && table.other[0] == 7.0);
+    assert(incstats_table_find(&table, 6) == NULL);
+    assert(incstats_table_find(&table, 7) != NULL);
+    assert(budget.used == 3 * incstats_table_entry_bytes(&table));
+    incstats_table_free(&table);
+
+    // With a spill file expired keys are reloaded when they reappear.
+    assert(incstats_table_init(&table, 3, incstats_variance, 
+                               incstats_variance_merge, &budget));
+    assert(incstats_table_set_spill(&table, path));
+    for(size_t t = 0; t < 2000; t++) {
+        // Keys 0 to 24 are active in the first half only, the others 
+        // throughout, and every key is expired after 10 idle steps.
+        uint64_t key = rand() % (t < 1000 ? 50 : 25) + (t < 1000 ? 0 : 25);
+        double x = random_normal();
+
+        if(t == 1500) {
+            key = 3;
+        }
+        incstats_table_set_time(&table, (double)t);
+        assert(incstats_table_update(&table, key, x, 1.0) != NULL);
+        incstats_variance(x, 1.0, reference[key]);
+        incstats_variance(x, 1.0, all);
+        if(t == 1500) {
+            // The reloaded key holds the values from before its spill.
+            double *state = incstats_table_find(&table, 3);
+            assert(state[0] == reference[3][0]);
+            assert(fabs(state[1] - reference[3][1]) <= 1e-12);
+            assert(fabs(state[2] - reference[3][2]) <= 1e-12 * state[2]);
+        }
+        assert(incstats_table_expire(&table, 10.0) != SIZE_MAX);
+    }
+    assert(table.spilled > 0 && table.count < 50);
+    assert(table.spilled + table.count == 50);
+    for(uint64_t key = 25; key < 50; key++) {
+        double *state = incstats_table_find(&table, key);
+        if(state != NULL) {
+            assert(state[0] == reference[key][0]);
+            assert(fabs(state[1] - reference[key][1]) <= 1e-12);
+            assert(fabs(state[2] - reference[key][2]) <= 
+                   1e-12 * reference[key][2]);
+        }
+    }
+    // Dropping the spill file merges the spilled keys into the other bucket.
+    assert(incstats_table_set_spill(&table, NULL));
+    assert(table.spilled == 0 && table.spill == NULL);
+    memcpy(merged, table.other, sizeof(merged));
+    for(size_t i = 0; i < table.count; i++) {
+        incstats_variance_merge(merged, &table.states[3 * i]);
+    }
+    assert(merged[0] == all[0]);
+    assert(fabs(merged[1] - all[1]) <= 1e-12);
+    assert(fabs(merged[2] - all[2]) <= 1e-12 * all[2]);
+    incstats_table_free(&table);
+    assert(budget.used == 0);
+
+    // A record that cannot be read stops the reload, and the keys merged 
+    // before it leave the index, so a retry does not merge them twice.
+    assert(incstats_table_init(&table, 3, incstats_variance, 
+                               incstats_variance_merge, &budget));
+    assert(incstats_table_set_spill(&table, path));
+    for(uint64_t key = 0; key < 3; key++) {
+        incstats_table_update(&table, key, (double)key, 1.0);
+    }
+    incstats_table_set_time(&table, 1.0);
+    assert(incstats_table_expire(&table, 0.5) == 3);
+    // Reloading key 0 moves key 2 to the front of the index, so key 1 is 
+    // reloaded first and the record of key 2 is the last one of the file.
+    incstats_table_update(&table, 0, 0.0, 1.0);
+    assert(table.spilled == 2);
+    assert(table.spill_keys[0] == 2 && table.spill_keys[1] == 1);
+    // Read the spilled keys from a copy of the file without that record.
+    length = (size_t)table.spill_offsets[0];
+    spill = table.spill;
+    fflush(spill);
+    file = fopen(path, "rb");
+    assert(fread(bytes, 1, length, file) == length);
+    fclose(file);
+    file = fopen(path_short, "wb");
+    assert(fwrite(bytes, 1, length, file) == length);
+    fclose(file);
+    table.spill = fopen(path_short, "rb");
+    for(size_t retry = 0; retry < 2; retry++) {
+        assert(!incstats_table_set_spill(&table, NULL));
+        assert(table.spilled == 1 && table.spill_keys[0] == 2);
+        assert(table.other[0] == 1.0 && table.other[1] == 1.0);
+    }
+    fclose(table.spill);
+    table.spill = spill;
+    remove(path_short);
+    assert(incstats_table_set_spill(&table, NULL));
+    assert(table.spilled == 0 && table.count == 1);
+    assert(table.other[0] == 2.0 && table.other[1] == 1.5);
+    incstats_table_free(&table);
+    assert(budget.used == 0);
+    remove(path);
+}
+
 int main(int argc, char const *argv[]) {
     srand(111111);
     printf("[i] Testing incstats_mean()...\n");
@@ -259,5 +1826,67 @@ int main(int argc, char const *argv[]) {
     test_incstats_min();
     printf("[i] Testing central_moment...\n");
     test_central_moment();
+    printf("[i] Testing incstats_summary()...\n");
+    test_incstats_summary();
+    printf("[i] Testing incstats_binomial()...\n");
+    test_incstats_binomial();
+    printf("[i] Testing central_moment with high orders...\n");
+    test_central_moment_high_order();
+    printf("[i] Testing incstats_moments...\n");
+    test_incstats_moments();
+    printf("[i] Testing incstats_central_moment_kernel()...\n");
+    test_central_moment_kernel();
+    printf("[i] Testing lazy finalize...\n");
+    test_incstats_lazy();
+    printf("[i] Testing incstats_kurtosis_finalize_bulk()...\n");
+    test_incstats_kurtosis_finalize_bulk();
+    printf("[i] Testing incstats_histogram()...\n");
+    test_incstats_histogram();
+    printf("[i] Testing run-length encoded updates...\n");
+    test_incstats_rle();
+    printf("[i] Testing log-weights...\n");
+    test_incstats_log_weights();
+    printf("[i] Testing incstats_variance_decay()...\n");
+    test_incstats_variance_decay();
+    printf("[i] Testing incstats_circular()...\n");
+    test_incstats_circular();
+    printf("[i] Testing incstats_pca()...\n");
+    test_incstats_pca();
+    printf("[i] Testing incstats_mahalanobis()...\n");
+    test_incstats_mahalanobis();
+    printf("[i] Testing incstats_comoment()...\n");
+    test_incstats_comoment();
+    printf("[i] Testing incstats_variance_merge()...\n");
+    test_incstats_variance_merge();
+    printf("[i] Testing incstats_gmm()...\n");
+    test_incstats_gmm();
+    printf("[i] Testing incstats_kmeans()...\n");
+    test_incstats_kmeans();
+    printf("[i] Testing incstats_normal_quantile()...\n");
+    test_incstats_normal_quantile();
+    printf("[i] Testing incstats_kurtosis_quantile_finalize()...\n");
+    test_incstats_kurtosis_quantile();
+    printf("[i] Testing incstats_central_moment_quantile_maxent()...\n");
+    test_incstats_central_moment_quantile_maxent();
+    printf("[i] Testing incstats_histogram_psi()...\n");
+    test_incstats_drift();
+    printf("[i] Testing incstats_histogram_distance_finalize()...\n");
+    test_incstats_histogram_distance();
+    printf("[i] Testing incstats_allan()...\n");
+    test_incstats_allan();
+    printf("[i] Testing incstats_joint_histogram()...\n");
+    test_incstats_joint_histogram();
+    printf("[i] Testing incstats_joint_histogram_entropy_finalize()...\n");
+    test_incstats_joint_histogram_entropy();
+    printf("[i] Testing incstats_holt_winters()...\n");
+    test_incstats_holt_winters();
+    printf("[i] Testing incstats_kalman()...\n");
+    test_incstats_kalman();
+    printf("[i] Testing incstats_kurtosis_merge()...\n");
+    test_incstats_kurtosis_merge();
+    printf("[i] Testing incstats_table_update()...\n");
+    test_incstats_table();
+    printf("[i] Testing incstats_table_expire()...\n");
+    test_incstats_table_expire();
     return 0;
 }
\ No newline at end of file